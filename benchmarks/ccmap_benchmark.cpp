@@ -0,0 +1,97 @@
+#include <stdio.h>
+#include <time.h>
+#include <stc/crandom.h>
+#include <thread>
+#include <mutex>
+#include <vector>
+
+/* Thread scaling: one cmap behind a single mutex vs. ccmap with a spinlock per shard.
+   Every thread fills its own key range with emplace_or_assign, then looks the keys up. */
+enum {N = 1 << 21};
+const int threads[] = {1, 2, 4, 8, 16, 32, 64};
+uint64_t seed = 1;
+
+#define i_tag x
+#define i_key size_t
+#define i_val size_t
+#define i_hash c_default_hash64
+#include <stc/ccmap.h>
+
+static uint64_t nanosecs(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec*1000000000ull + ts.tv_nsec;
+}
+
+struct Result { double insert, find; size_t size, sum; };
+
+template <class Insert, class Find>
+static Result run(int nthreads, Insert insert, Find find) {
+    std::vector<std::thread> pool;
+    std::vector<size_t> sums(nthreads);
+    size_t per = N / nthreads;
+    Result r;
+    uint64_t t0 = nanosecs();
+    for (int t = 0; t < nthreads; ++t)
+        pool.emplace_back([=]() {
+            stc64_t rng = stc64_init(seed + t);
+            for (size_t i = 0; i < per; ++i)
+                insert((stc64_rand(&rng) << 6) | t, i);
+        });
+    for (auto& th : pool) th.join();
+    uint64_t t1 = nanosecs();
+    pool.clear();
+    for (int t = 0; t < nthreads; ++t)
+        pool.emplace_back([=, &sums]() {
+            stc64_t rng = stc64_init(seed + t);
+            size_t sum = 0;
+            for (size_t i = 0; i < per; ++i)
+                sum += find((stc64_rand(&rng) << 6) | t);
+            sums[t] = sum;
+        });
+    for (auto& th : pool) th.join();
+    uint64_t t2 = nanosecs();
+    r.insert = (t1 - t0)*1e-9, r.find = (t2 - t1)*1e-9, r.sum = 0;
+    for (size_t s : sums) r.sum += s;
+    return r;
+}
+
+static Result run_mutex(int nthreads) {
+    cmap_x map = cmap_x_init();
+    std::mutex mtx;
+    Result r = run(nthreads,
+        [&](size_t k, size_t v) { std::lock_guard<std::mutex> g(mtx); cmap_x_emplace_or_assign(&map, k, v); },
+        [&](size_t k) { std::lock_guard<std::mutex> g(mtx); cmap_x_value_t* v = cmap_x_get(&map, k);
+                        return v ? v->second : 0; });
+    r.size = cmap_x_size(map);
+    cmap_x_del(&map);
+    return r;
+}
+
+static Result run_sharded(int nthreads) {
+    ccmap_x map = ccmap_x_init();
+    Result r = run(nthreads,
+        [&](size_t k, size_t v) { ccmap_x_emplace_or_assign(&map, k, v); },
+        [&](size_t k) { size_t v = 0; ccmap_x_get_copy(&map, k, &v); return v; });
+    r.size = ccmap_x_size(&map);
+    ccmap_x_del(&map);
+    return r;
+}
+
+int main(int argc, char* argv[])
+{
+    const char* comp = argc > 1 ? argv[1] : "test";
+    bool header = (argc > 2 && argv[2][0] == '1');
+
+    if (header) printf("Compiler,Library,C,Threads,insert(s),find(s),Size,Sum,Speedup\n");
+    for (int nt : threads) {
+        Result m = run_mutex(nt), s = run_sharded(nt);
+        if (m.size != s.size || m.sum != s.sum) {
+            printf("ccmap mismatch: %zu %zu, %zu %zu\n", m.size, s.size, m.sum, s.sum);
+            return 1;
+        }
+        printf("%s,STC,cmap+mutex n:%d,%d,%.3f,%.3f,%zu,%zu,\n", comp, N, nt, m.insert, m.find, m.size, m.sum);
+        printf("%s,STC,ccmap n:%d,%d,%.3f,%.3f,%zu,%zu,%.2f\n", comp, N, nt, s.insert, s.find, s.size, s.sum,
+               (m.insert + m.find)/(s.insert + s.find));
+    }
+}
@@ -21,6 +21,28 @@ static float secs(Range s) { return (float)(s.t2 - s.t1) / CLOCKS_PER_SEC; }
 #define i_hash c_default_hash64
 #include <stc/cmap.h>
 
+#define i_tag xs
+#define i_key size_t
+#define i_val size_t
+#define i_hash c_default_hash64
+#define i_simd
+#include <stc/cmap.h>
+
+#define i_tag xr
+#define i_key size_t
+#define i_val size_t
+#define i_hash c_default_hash64
+#define i_robinhood
+#include <stc/cmap.h>
+
+/* Lookups at high load factor: scalar vs. SIMD group probing of the metadata and
+   Robin Hood ordering, one by one and batched with contains_n(). */
+enum {FIND_HIT, FIND_MISS, FIND_BATCH, N_PROBES};
+const char* probe_ops[] = {"find-hit", "find-miss", "find-hit-batch"};
+enum {BATCH = 256};
+typedef struct { const char* name; Range test[N_PROBES]; } ProbeSample;
+const float probe_load = 0.9f;
+
 #ifdef __cplusplus
 Sample test_std_unordered_map() {
     typedef std::unordered_map<size_t, size_t> container;
@@ -108,6 +130,105 @@ Sample test_stc_unordered_map() {
      return s;
 }
 
+ProbeSample test_stc_probe_scalar() {
+    ProbeSample s = {"STC,unordered_map,scalar"};
+    cmap_x con = cmap_x_init();
+    cmap_x_max_load_factor(&con, probe_load);
+    cmap_x_reserve(&con, N/2);
+    stc64_srandom(seed);
+    while (cmap_x_size(con) < cmap_x_capacity(con) - 1) cmap_x_emplace(&con, stc64_random() & mask1, 1);
+    stc64_srandom(seed);
+    s.test[FIND_HIT].t1 = clock();
+    size_t sum = 0;
+    c_forrange (N) sum += cmap_x_contains(&con, stc64_random() & mask1);
+    s.test[FIND_HIT].t2 = clock();
+    s.test[FIND_HIT].sum = sum;
+    stc64_srandom(seed + 1);
+    s.test[FIND_MISS].t1 = clock();
+    sum = 0;
+    c_forrange (N) sum += cmap_x_contains(&con, stc64_random() & mask1);
+    s.test[FIND_MISS].t2 = clock();
+    s.test[FIND_MISS].sum = sum;
+    stc64_srandom(seed);
+    s.test[FIND_BATCH].t1 = clock();
+    sum = 0;
+    size_t keys[BATCH];
+    c_forrange (N/BATCH) {
+        c_forrange (i, BATCH) keys[i] = stc64_random() & mask1;
+        sum += cmap_x_contains_n(&con, keys, BATCH, NULL);
+    }
+    s.test[FIND_BATCH].t2 = clock();
+    s.test[FIND_BATCH].sum = sum;
+    cmap_x_del(&con);
+    return s;
+}
+
+ProbeSample test_stc_probe_simd() {
+    ProbeSample s = {"STC,unordered_map,simd"};
+    cmap_xs con = cmap_xs_init();
+    cmap_xs_max_load_factor(&con, probe_load);
+    cmap_xs_reserve(&con, N/2);
+    stc64_srandom(seed);
+    while (cmap_xs_size(con) < cmap_xs_capacity(con) - 1) cmap_xs_emplace(&con, stc64_random() & mask1, 1);
+    stc64_srandom(seed);
+    s.test[FIND_HIT].t1 = clock();
+    size_t sum = 0;
+    c_forrange (N) sum += cmap_xs_contains(&con, stc64_random() & mask1);
+    s.test[FIND_HIT].t2 = clock();
+    s.test[FIND_HIT].sum = sum;
+    stc64_srandom(seed + 1);
+    s.test[FIND_MISS].t1 = clock();
+    sum = 0;
+    c_forrange (N) sum += cmap_xs_contains(&con, stc64_random() & mask1);
+    s.test[FIND_MISS].t2 = clock();
+    s.test[FIND_MISS].sum = sum;
+    stc64_srandom(seed);
+    s.test[FIND_BATCH].t1 = clock();
+    sum = 0;
+    size_t keys[BATCH];
+    c_forrange (N/BATCH) {
+        c_forrange (i, BATCH) keys[i] = stc64_random() & mask1;
+        sum += cmap_xs_contains_n(&con, keys, BATCH, NULL);
+    }
+    s.test[FIND_BATCH].t2 = clock();
+    s.test[FIND_BATCH].sum = sum;
+    cmap_xs_del(&con);
+    return s;
+}
+
+ProbeSample test_stc_probe_robinhood() {
+    ProbeSample s = {"STC,unordered_map,robinhood"};
+    cmap_xr con = cmap_xr_init();
+    cmap_xr_max_load_factor(&con, probe_load);
+    cmap_xr_reserve(&con, N/2);
+    stc64_srandom(seed);
+    while (cmap_xr_size(con) < cmap_xr_capacity(con) - 1) cmap_xr_emplace(&con, stc64_random() & mask1, 1);
+    stc64_srandom(seed);
+    s.test[FIND_HIT].t1 = clock();
+    size_t sum = 0;
+    c_forrange (N) sum += cmap_xr_contains(&con, stc64_random() & mask1);
+    s.test[FIND_HIT].t2 = clock();
+    s.test[FIND_HIT].sum = sum;
+    stc64_srandom(seed + 1);
+    s.test[FIND_MISS].t1 = clock();
+    sum = 0;
+    c_forrange (N) sum += cmap_xr_contains(&con, stc64_random() & mask1);
+    s.test[FIND_MISS].t2 = clock();
+    s.test[FIND_MISS].sum = sum;
+    stc64_srandom(seed);
+    s.test[FIND_BATCH].t1 = clock();
+    sum = 0;
+    size_t keys[BATCH];
+    c_forrange (N/BATCH) {
+        c_forrange (i, BATCH) keys[i] = stc64_random() & mask1;
+        sum += cmap_xr_contains_n(&con, keys, BATCH, NULL);
+    }
+    s.test[FIND_BATCH].t2 = clock();
+    s.test[FIND_BATCH].sum = sum;
+    cmap_xr_del(&con);
+    return s;
+}
+
 int main(int argc, char* argv[])
 {
     Sample std_s[SAMPLES + 1], stc_s[SAMPLES + 1];
@@ -129,4 +250,14 @@ int main(int argc, char* argv[])
                             printf("%s,%s n:%d,%s,%.3f,%.3f\n", comp, std_s[0].name, N, "total", std_sum, 1.0f);
     c_forrange (j, N_TESTS) printf("%s,%s n:%d,%s,%.3f,%.3f\n", comp, stc_s[0].name, N, operations[j], secs(stc_s[0].test[j]), secs(std_s[0].test[j]) ? secs(stc_s[0].test[j])/secs(std_s[0].test[j]) : 1.0f);
                             printf("%s,%s n:%d,%s,%.3f,%.3f\n", comp, stc_s[0].name, N, "total", stc_sum, stc_sum/std_sum);
+
+    ProbeSample scalar = test_stc_probe_scalar(), variants[2] = {test_stc_probe_simd(), test_stc_probe_robinhood()};
+    c_forrange (j, N_PROBES) {
+        c_forrange (k, 2) if (scalar.test[j].sum != variants[k].test[j].sum)
+            printf("Error in sum: probe test %d, %s\n", (int) j, variants[k].name);
+        printf("%s,%s lf:%.2f,%s,%.3f,%.3f\n", comp, scalar.name, probe_load, probe_ops[j], secs(scalar.test[j]), 1.0f);
+    }
+    c_forrange (k, 2) c_forrange (j, N_PROBES)
+        printf("%s,%s lf:%.2f,%s,%.3f,%.3f\n", comp, variants[k].name, probe_load, probe_ops[j], secs(variants[k].test[j]),
+               secs(scalar.test[j]) ? secs(variants[k].test[j])/secs(scalar.test[j]) : 1.0f);
 }
\ No newline at end of file
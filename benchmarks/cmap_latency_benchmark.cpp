@@ -0,0 +1,68 @@
+#include <stdio.h>
+#include <time.h>
+#include <stc/crandom.h>
+
+/* Insert latency percentiles: full rehash on growth vs. incremental rehash (i_incremental). */
+enum {N = 4000000};
+uint64_t seed = 1, mask1 = 0xffffffff;
+
+#define i_tag x
+#define i_key size_t
+#define i_val size_t
+#define i_hash c_default_hash64
+#include <stc/cmap.h>
+
+#define i_tag xi
+#define i_key size_t
+#define i_val size_t
+#define i_hash c_default_hash64
+#define i_incremental
+#include <stc/cmap.h>
+
+static uint64_t nanosecs(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec*1000000000ull + ts.tv_nsec;
+}
+
+static int cmp_u32(const void* a, const void* b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void report(const char* comp, const char* name, uint32_t* lat, uint64_t total, size_t sum) {
+    qsort(lat, N, sizeof *lat, cmp_u32);
+    printf("%s,%s n:%d,insert,%.3f,%.3f,%.3f,%.3f,%.3f,%zu\n", comp, name, N, total*1e-9,
+           lat[N/2]*1e-3, lat[(size_t) (N*0.99)]*1e-3, lat[(size_t) (N*0.999)]*1e-3, lat[N - 1]*1e-3, sum);
+}
+
+int main(int argc, char* argv[])
+{
+    const char* comp = argc > 1 ? argv[1] : "test";
+    bool header = (argc > 2 && argv[2][0] == '1');
+    uint32_t* lat = c_new_n(uint32_t, N);
+    uint64_t t0, t1, total;
+
+    if (header) printf("Compiler,Library,C,Method,Seconds,p50(us),p99(us),p999(us),max(us),Size\n");
+    c_autovar (cmap_x con = cmap_x_init(), cmap_x_del(&con)) {
+        stc64_srandom(seed);
+        total = 0;
+        c_forrange (i, N) {
+            size_t key = stc64_random() & mask1;
+            t0 = nanosecs(); cmap_x_emplace(&con, key, i); t1 = nanosecs();
+            lat[i] = (uint32_t) (t1 - t0); total += t1 - t0;
+        }
+        report(comp, "STC,unordered_map", lat, total, cmap_x_size(con));
+    }
+    c_autovar (cmap_xi con = cmap_xi_init(), cmap_xi_del(&con)) {
+        stc64_srandom(seed);
+        total = 0;
+        c_forrange (i, N) {
+            size_t key = stc64_random() & mask1;
+            t0 = nanosecs(); cmap_xi_emplace(&con, key, i); t1 = nanosecs();
+            lat[i] = (uint32_t) (t1 - t0); total += t1 - t0;
+        }
+        report(comp, "STC,unordered_map,incremental", lat, total, cmap_xi_size(con));
+    }
+    c_free(lat);
+}
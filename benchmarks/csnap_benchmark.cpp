@@ -0,0 +1,136 @@
+#include <stdio.h>
+#include <time.h>
+#include <stc/crandom.h>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <vector>
+
+/* Reader scaling: lookups into a table that a writer thread rebuilds and replaces
+   while the readers run. std::mutex and std::shared_mutex vs. csnap publication. */
+enum {N = 1 << 21, KEYS = 10000};
+const int threads[] = {1, 2, 4, 8, 16, 32, 64};
+uint64_t seed = 1;
+
+#define i_tag x
+#define i_key size_t
+#define i_val size_t
+#define i_hash c_default_hash64
+#include <stc/cmap.h>
+
+#define i_tag x
+#define i_val cmap_x
+#define i_valdel cmap_x_del
+#define i_valfrom cmap_x_clone
+#include <stc/csnap.h>
+
+static uint64_t nanosecs(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec*1000000000ull + ts.tv_nsec;
+}
+
+static cmap_x make_table(void) {
+    cmap_x m = cmap_x_with_capacity(KEYS + 1);
+    c_forrange (i, KEYS) cmap_x_emplace(&m, i, i*i);
+    return m;
+}
+
+/* The writer only bumps a version entry, so the lookup sums are deterministic. */
+static void rebuild(cmap_x* m) {
+    cmap_x_value_t* v = cmap_x_get(m, KEYS);
+    if (v) ++v->second; else cmap_x_emplace(m, KEYS, 1);
+}
+
+struct Result { double secs; size_t sum, updates; };
+
+template <class Lookup, class Update>
+static Result run(int nreaders, Lookup lookup, Update update) {
+    std::vector<std::thread> pool;
+    std::vector<size_t> sums(nreaders);
+    std::atomic<int> running(nreaders);
+    size_t per = N / nreaders, updates = 0;
+    uint64_t t0 = nanosecs();
+    for (int t = 0; t < nreaders; ++t)
+        pool.emplace_back([=, &sums, &running]() {
+            stc64_t rng = stc64_init(seed + t);
+            size_t sum = 0;
+            for (size_t i = 0; i < per; ++i)
+                sum += lookup(t, stc64_rand(&rng) % KEYS);
+            sums[t] = sum;
+            --running;
+        });
+    while (running > 0) {
+        update();
+        ++updates;
+        std::this_thread::yield();
+    }
+    for (auto& th : pool) th.join();
+    Result r = {(nanosecs() - t0)*1e-9, 0, updates};
+    for (size_t s : sums) r.sum += s;
+    return r;
+}
+
+static Result run_mutex(int nreaders) {
+    cmap_x map = make_table();
+    std::mutex mtx;
+    Result r = run(nreaders,
+        [&](int, size_t k) { std::lock_guard<std::mutex> g(mtx); return cmap_x_get(&map, k)->second; },
+        [&]() { cmap_x next;
+                { std::lock_guard<std::mutex> g(mtx); next = cmap_x_clone(map); }
+                rebuild(&next);
+                std::lock_guard<std::mutex> g(mtx); cmap_x_del(&map); map = next; });
+    cmap_x_del(&map);
+    return r;
+}
+
+static Result run_shared_mutex(int nreaders) {
+    cmap_x map = make_table();
+    std::shared_mutex mtx;
+    Result r = run(nreaders,
+        [&](int, size_t k) { std::shared_lock<std::shared_mutex> g(mtx); return cmap_x_get(&map, k)->second; },
+        [&]() { cmap_x next;
+                { std::shared_lock<std::shared_mutex> g(mtx); next = cmap_x_clone(map); }
+                rebuild(&next);
+                std::unique_lock<std::shared_mutex> g(mtx); cmap_x_del(&map); map = next; });
+    cmap_x_del(&map);
+    return r;
+}
+
+static Result run_snapshot(int nreaders) {
+    csnap_x snap = csnap_x_make(make_table());
+    std::vector<csnap_reader_t*> readers(nreaders);
+    for (auto& r : readers) r = csnap_x_register(&snap);
+    Result r = run(nreaders,
+        [&](int t, size_t k) { const cmap_x* m = csnap_x_read_lock(&snap, readers[t]);
+                               size_t v = cmap_x_get(m, k)->second;
+                               csnap_x_read_unlock(readers[t]); return v; },
+        [&]() { cmap_x next = csnap_x_clone_current(&snap);
+                rebuild(&next);
+                csnap_x_publish(&snap, next); });
+    for (auto& r : readers) csnap_x_unregister(r);
+    csnap_x_synchronize(&snap);
+    csnap_x_del(&snap);
+    return r;
+}
+
+int main(int argc, char* argv[])
+{
+    const char* comp = argc > 1 ? argv[1] : "test";
+    bool header = (argc > 2 && argv[2][0] == '1');
+
+    if (header) printf("Compiler,Library,C,Readers,Seconds,Lookups/s,Updates,Sum\n");
+    for (int nt : threads) {
+        Result res[3] = {run_mutex(nt), run_shared_mutex(nt), run_snapshot(nt)};
+        const char* names[3] = {"cmap+mutex", "cmap+shared_mutex", "csnap"};
+        c_forrange (i, 3) {
+            if (res[i].sum != res[0].sum) {
+                printf("csnap mismatch: %zu %zu\n", res[0].sum, res[i].sum);
+                return 1;
+            }
+            printf("%s,STC,%s n:%d,%d,%.3f,%.0f,%zu,%zu\n", comp, names[i], N, nt, res[i].secs,
+                   N/res[i].secs, res[i].updates, res[i].sum);
+        }
+    }
+}
@@ -0,0 +1,50 @@
+// A Bloom filter in front of a map: most lookups of absent keys never reach the map.
+#include <stdio.h>
+#include <stc/crandom.h>
+
+#define i_key uint64_t
+#define i_val int
+#define i_tag u
+#include <stc/cmap.h>
+
+#define i_key uint64_t
+#define i_tag u
+#include <stc/cbloom.h>
+
+int main()
+{
+    enum { N = 200000, Q = 1000000, B = 1000 };
+    const double rate = 0.01;
+    stc64_t rng = stc64_init(1234);
+    static uint64_t keys[B], present[N];
+    static bool maybe[B];
+
+    c_auto (cmap_u, store)
+    c_autovar (cbloom_u filter = cbloom_u_with_capacity(N, rate), cbloom_u_del(&filter))
+    {
+        c_forrange (i, N) {
+            uint64_t key = present[i] = stc64_rand(&rng);
+            cmap_u_insert(&store, key, (int) i);
+            cbloom_u_add(&filter, key);
+        }
+        size_t probed = 0, found = 0, missed = 0;
+        c_forrange (i, Q/B) {
+            c_forrange (j, B) keys[j] = stc64_rand(&rng); /* absent keys... */
+            c_forrange (j, B/10) keys[j*10] = present[(i*B + j) % N]; /* ...and some present */
+            cbloom_u_maybe_contains_n(&filter, keys, B, maybe);
+            c_forrange (j, B) {
+                bool in_map = cmap_u_contains(&store, keys[j]);
+                if (maybe[j]) ++probed, found += in_map; /* only these would go to the map */
+                else missed += in_map;
+            }
+        }
+        size_t fp = probed - found;
+        double fpr = (double) fp / (Q - found);
+        printf("filter: %zu blocks, %u bits per key, %.1f bits per key\n", cbloom_u_block_count(filter),
+               cbloom_u_hash_count(filter), 512.0*cbloom_u_block_count(filter) / N);
+        printf("map lookups: %zu of %d, hits: %zu, false positive rate: %.4f (model %.4f)\n",
+               probed, Q, found, fpr, cbloom_u_fpr(&filter, N));
+        printf("estimated count: %zu of %d\n", cbloom_u_estimate_count(&filter), N);
+        if (missed || fpr > 2*rate) return 1;
+    }
+}
@@ -0,0 +1,51 @@
+// Range scans over an ordered index of timestamps, in a B+ tree and in an AA-tree.
+#include <stdio.h>
+#include <stc/crandom.h>
+
+#define i_key uint64_t
+#define i_val uint32_t
+#define i_tag ts
+#include <stc/cbtmap.h>
+
+#define i_key uint64_t
+#define i_val uint32_t
+#define i_tag ts
+#include <stc/csmap.h>
+
+int main()
+{
+    enum { N = 200000, Q = 2000, WINDOW = 500000000 };
+    stc64_t rng = stc64_init(99);
+    int errors = 0;
+
+    c_auto (cbtmap_ts, events)
+    c_auto (csmap_ts, check)
+    {
+        c_forrange (i, N) {
+            uint64_t ts = stc64_rand(&rng) >> 24; /* 40-bit timestamps */
+            cbtmap_ts_insert(&events, ts, (uint32_t) i);
+            csmap_ts_insert(&check, ts, (uint32_t) i);
+        }
+        size_t scanned = 0;
+        c_forrange (Q) { /* count and sum the event ids in a time window */
+            uint64_t t0 = stc64_rand(&rng) >> 24, n1 = 0, n2 = 0, s1 = 0, s2 = 0;
+            c_foreach (i, cbtmap_ts, cbtmap_ts_lower_bound(&events, t0), cbtmap_ts_lower_bound(&events, t0 + WINDOW))
+                ++n1, s1 += i.ref->second;
+            c_foreach (i, csmap_ts, csmap_ts_lower_bound(&check, t0), csmap_ts_lower_bound(&check, t0 + WINDOW))
+                ++n2, s2 += i.ref->second;
+            errors += n1 != n2 || s1 != s2;
+            scanned += n1;
+        }
+        /* expire the oldest half */
+        uint64_t mid = cbtmap_ts_advance(cbtmap_ts_begin(&events), N/2).ref->first;
+        cbtmap_ts_erase_range(&events, cbtmap_ts_begin(&events), cbtmap_ts_lower_bound(&events, mid));
+        csmap_ts_erase_range(&check, csmap_ts_begin(&check), csmap_ts_lower_bound(&check, mid));
+        errors += cbtmap_ts_size(events) != csmap_ts_size(check);
+        errors += cbtmap_ts_front(&events)->first != mid || cbtmap_ts_back(&events)->first != csmap_ts_back(&check)->first;
+
+        printf("events: %zu, tree height: %zu, scanned per query: %zu\n",
+               cbtmap_ts_size(events), cbtmap_ts_height(events), scanned / Q);
+    }
+    printf("errors: %d\n", errors);
+    return errors != 0;
+}
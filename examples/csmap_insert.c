@@ -79,6 +79,15 @@ int main()
         puts("The modified key and mapped values of m2 are:");
         c_foreach (e, csmap_ii, m2) printf("(%d, %d) ", e.ref->first, e.ref->second);
         puts("\n");
+
+        // Bulk construction: sorts the vector, then builds a balanced tree in O(n)
+        c_autovar (csmap_ii m2b = csmap_ii_build(v.data, cvec_ii_size(v)), csmap_ii_del(&m2b)) {
+            puts("Built from the same vector data, m2b contains:");
+            print_ii(m2b);
+            puts("");
+            if (csmap_ii_size(m2b) != csmap_ii_size(m2)) return 1;
+            c_foreach (e, csmap_ii, m2) if (*csmap_ii_at(&m2b, e.ref->first) != e.ref->second) return 1;
+        }
     }
 
     // The templatized versions move-constructing elements
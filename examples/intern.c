@@ -0,0 +1,46 @@
+// Count log records per host: the host names are interned, so the counting map is keyed by pointer.
+#include <stdio.h>
+#include <stc/cintern.h>
+#include <stc/crandom.h>
+
+#define i_key const char* /* interned: hashed and compared as pointers */
+#define i_val int
+#define i_tag host
+#include <stc/cmap.h>
+
+#define i_key_str
+#define i_val int
+#include <stc/cmap.h>
+
+int main()
+{
+    enum { N = 200000, HOSTS = 300 };
+    stc64_t rng = stc64_init(7);
+    stc64_uniform_t dist = stc64_uniform_init(0, HOSTS - 1);
+    int errors = 0;
+    char line[64];
+
+    c_auto (cintern, pool)
+    c_auto (cmap_host, count)
+    c_auto (cmap_str, check)
+    {
+        c_forrange (N) {
+            int len = sprintf(line, "web-%02d.example.org GET /", (int) stc64_uniform(&rng, &dist));
+            csview host = csview_first_token(csview_from_n(line, len), c_sv(" "));
+
+            const char* h = cintern_get_v(&pool, host);
+            ++cmap_host_emplace(&count, h, 0).ref->second;
+            ++cmap_str_emplace_v(&check, host, 0).ref->second;
+        }
+        errors += cintern_size(pool) != cmap_str_size(check);
+        c_foreach (i, cmap_str, check) {
+            const char* h = cintern_find(&pool, i.ref->first.str);
+            errors += !h || cmap_host_get(&count, h)->second != i.ref->second;
+            errors += cintern_str(&pool, cintern_id(h)) != h;
+        }
+        const char* h = cintern_str(&pool, 0);
+        printf("hosts: %zu, first: %s with %d records\n", cintern_size(pool), h, cmap_host_get(&count, h)->second);
+    }
+    printf("errors: %d\n", errors);
+    return errors != 0;
+}
@@ -0,0 +1,62 @@
+// An LRU cache and a CLOCK cache in front of a slow lookup, with a skewed key distribution.
+#include <stdio.h>
+#include <time.h>
+#include <stc/crandom.h>
+
+#define i_tag u
+#define i_key uint64_t
+#define i_val uint64_t
+#include <stc/clru.h>
+
+#define i_tag c
+#define i_key uint64_t
+#define i_val uint64_t
+#define i_clock
+#include <stc/clru.h>
+
+static uint64_t slow_lookup(uint64_t key) { return key * 0x9E3779B97F4A7C15ull; }
+
+static uint64_t keygen(stc64_t* rng) { // three of four lookups go to 1000 hot keys
+    uint64_t r = stc64_rand(rng);
+    return (r & 3) ? (r >> 2) % 1000 : (r >> 2) % 100000;
+}
+
+static size_t evicted;
+static void on_evict(uint64_t key, uint64_t* val, void* ctx) {
+    (void) ctx; if (*val == slow_lookup(key)) ++evicted;
+}
+
+int main()
+{
+    enum { CAP = 2000, N = 3000000 };
+    stc64_t rng;
+    clock_t t;
+    size_t hits, wrong = 0;
+
+    c_autovar (clru_u lru = clru_u_with_capacity(CAP), clru_u_del(&lru))
+    {
+        clru_u_set_on_evict(&lru, on_evict, NULL);
+        rng = stc64_init(42); t = clock(); hits = 0;
+        c_forrange (N) {
+            uint64_t key = keygen(&rng), *v = clru_u_get(&lru, key);
+            if (v) ++hits; else v = clru_u_put(&lru, key, slow_lookup(key));
+            wrong += *v != slow_lookup(key);
+        }
+        printf("lru:   %.3fs, hit rate %.3f\n", (float)(clock() - t)/CLOCKS_PER_SEC, (double) hits/N);
+        if (clru_u_size(lru) != CAP || evicted != N - hits - CAP) return 1;
+    }
+
+    c_autovar (clru_c lru = clru_c_with_capacity(CAP), clru_c_del(&lru))
+    {
+        rng = stc64_init(42); t = clock(); hits = 0;
+        c_forrange (N) {
+            uint64_t key = keygen(&rng), *v = clru_c_get(&lru, key);
+            if (v) ++hits; else v = clru_c_put(&lru, key, slow_lookup(key));
+            wrong += *v != slow_lookup(key);
+        }
+        printf("clock: %.3fs, hit rate %.3f\n", (float)(clock() - t)/CLOCKS_PER_SEC, (double) hits/N);
+        if (clru_c_size(lru) != CAP) return 1;
+    }
+    if (wrong) return 1;
+    puts("ok");
+}
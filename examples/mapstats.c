@@ -0,0 +1,59 @@
+// Diagnose a weak hash function for a composite key with cmap_X_stats().
+#include <stdio.h>
+#include <stdint.h>
+
+struct Point { int x, y; } typedef Point;
+
+int point_equals(const Point* a, const Point* b) { return a->x == b->x && a->y == b->y; }
+uint64_t point_weakhash(const Point* p, size_t n) { (void)n; return (uint64_t) (p->x ^ p->y); }
+
+#define i_tag weak
+#define i_key Point
+#define i_val int
+#define i_equ point_equals
+#define i_hash point_weakhash
+#define i_stats
+#include <stc/cmap.h>
+
+#define i_tag good
+#define i_key Point
+#define i_val int
+#define i_equ point_equals
+#define i_stats
+#include <stc/cmap.h>
+
+static void print_stats(const char* name, chash_stats_t st) {
+    printf("%s: size %zu, buckets %zu, bytes %zu\n", name, st.size, st.bucket_count, st.bytes);
+    printf("  probe length avg %.2f, max %zu; clusters %zu, longest %zu\n",
+           st.avg_probe_length, st.max_probe_length, st.clusters, st.max_cluster);
+    printf("  histogram:");
+    c_forrange (i, _cmap_PROBE_BINS) printf(" %zu", st.probe_histogram[i]);
+    printf("\n  rehashes %zu, probes %zu, equal calls %zu\n", st.rehashes, st.probes, st.equal_calls);
+}
+
+int main()
+{
+    c_auto (cmap_weak, weak)
+    c_auto (cmap_good, good)
+    {
+        c_forrange (x, int, 64) c_forrange (y, int, 64) {
+            cmap_weak_emplace(&weak, (Point){x, y}, x*y);
+            cmap_good_emplace(&good, (Point){x, y}, x*y);
+        }
+        long sum1 = 0, sum2 = 0;
+        c_forrange (x, int, 64) c_forrange (y, int, 64) {
+            sum1 += *cmap_weak_at(&weak, (Point){x, y});
+            sum2 += *cmap_good_at(&good, (Point){x, y});
+        }
+        printf("sums: %ld %ld\n", sum1, sum2);
+        chash_stats_t w = cmap_weak_stats(&weak), g = cmap_good_stats(&good);
+        print_stats("x ^ y", w);
+        print_stats("c_default_hash", g);
+        if (w.size != g.size || w.max_probe_length <= g.max_probe_length || w.equal_calls <= g.equal_calls)
+            return 1;
+    }
+    c_auto (cmap_good, one) { /* the first table is not counted as a rehash */
+        cmap_good_emplace(&one, (Point){1, 2}, 3);
+        if (cmap_good_stats(&one).rehashes != 0) return 1;
+    }
+}
@@ -0,0 +1,46 @@
+// Latency percentiles over a sliding window: a sorted multiset with subtree counts finds
+// the k-th smallest sample in O(log n), where a walk through the set takes O(n).
+#include <stdio.h>
+#include <stc/crandom.h>
+
+#define i_key int
+#define i_tag lat
+#define i_ordstat
+#include <stc/csmultiset.h>
+
+int main()
+{
+    enum { N = 200000, W = 10000 };
+    static int window[W];
+    stc64_t rng = stc64_init(42);
+    stc64_normalf_t dist = stc64_normalf_init(200.0, 40.0);
+
+    c_auto (csmultiset_lat, samples)
+    {
+        c_forrange (i, N) {
+            int us = (int) stc64_normalf(&rng, &dist);
+            if (us < 1) us = 1;
+            if (i >= W) csmultiset_lat_erase(&samples, window[i % W]); /* oldest sample leaves */
+            csmultiset_lat_insert(&samples, window[i % W] = us);
+
+            if ((i + 1) % 50000 == 0) {
+                size_t n = csmultiset_lat_size(samples);
+                int p50 = *csmultiset_lat_at_index(&samples, n/2);
+                int p99 = *csmultiset_lat_at_index(&samples, n*99/100);
+                size_t slow = n - csmultiset_lat_rank(&samples, 300);
+                printf("after %d: p50 %d us, p99 %d us, %zu of %zu samples >= 300 us\n",
+                       (int) i + 1, p50, p99, slow, n);
+
+                /* check against a walk through the set */
+                size_t k = 0, below = 0;
+                c_foreach (j, csmultiset_lat, samples) {
+                    if (k == n/2 && *j.ref != p50) return 1;
+                    if (k == n*99/100 && *j.ref != p99) return 1;
+                    below += *j.ref >= 150 && *j.ref < 250;
+                    ++k;
+                }
+                if (below != csmultiset_lat_count_range(&samples, 150, 250)) return 1;
+            }
+        }
+    }
+}
@@ -0,0 +1,149 @@
+// Save maps of plain-old-data to files, and map the images back without rebuilding them.
+#include <stdio.h>
+#include <stddef.h>
+#include <stc/crandom.h>
+
+#define i_tag ii
+#define i_key int
+#define i_val int
+#define i_persist
+#include <stc/cmap.h>
+
+#define i_tag uu
+#define i_key uint64_t
+#define i_val double
+#define i_storehash
+#define i_persist
+#include <stc/cmap.h>
+
+#define i_tag ii
+#define i_key int
+#define i_val int
+#define i_persist
+#include <stc/csmap.h>
+
+#define i_tag ii
+#define i_key int
+#define i_val int
+#define i_persist
+#include <stc/csmultimap.h>
+
+#define i_tag io
+#define i_key int
+#define i_val int
+#define i_ordstat
+#define i_persist
+#include <stc/csmap.h>
+
+/* Overwrite a field of a saved image, as a corrupt or crafted file would have it. */
+static int patch_file(const char* path, size_t pos, const void* value, size_t n) {
+    FILE* f = fopen(path, "r+b");
+    int ok = f && !fseek(f, (long) pos, SEEK_SET) && fwrite(value, n, 1, f) == 1;
+    if (f) fclose(f);
+    return ok;
+}
+
+int main()
+{
+    const char* path = "persist_example.bin";
+    FILE* fp;
+
+    c_auto (cmap_ii, map)
+    {
+        c_forrange (i, int, 1000) cmap_ii_emplace(&map, i*7, i);
+        cmap_ii_erase(&map, 70);
+        fp = fopen(path, "wb");
+        if (!fp || !cmap_ii_save(&map, fp)) return 1;
+        fclose(fp);
+
+        cmap_ii img = cmap_ii_map_file(path);
+        if (!cmap_ii_is_mapped(&img) || cmap_ii_is_mapped(&map)) return 1;
+        size_t n = 0;
+        c_foreach (i, cmap_ii, img) n += (*cmap_ii_at(&map, i.ref->first) == i.ref->second);
+        printf("cmap: %zu of %zu entries found, 70: %d, 7: %d\n",
+               n, cmap_ii_size(img), cmap_ii_contains(&img, 70), *cmap_ii_at(&img, 7));
+        cmap_ii_unmap(&img);
+
+        /* Images whose header does not match the file size are rejected. */
+        uint64_t cap = map.bucket_count + 64;
+        uint32_t hxsize = (uint32_t) cap + 1;
+        if (!patch_file(path, offsetof(_cmap_image_t, bucket_count), &cap, sizeof cap) ||
+            !patch_file(path, offsetof(_cmap_image_t, hxsize), &hxsize, sizeof hxsize)) return 1;
+        img = cmap_ii_map_file(path);
+        if (cmap_ii_is_mapped(&img) || cmap_ii_size(img)) return 1;
+        cap = map.bucket_count, hxsize = (uint32_t) cap + 1;
+        if (!patch_file(path, offsetof(_cmap_image_t, bucket_count), &cap, sizeof cap) ||
+            !patch_file(path, offsetof(_cmap_image_t, hxsize), &hxsize, sizeof hxsize)) return 1;
+        img = cmap_ii_map_file(path); /* restored */
+        if (!cmap_ii_is_mapped(&img)) return 1;
+        cmap_ii_unmap(&img);
+        if (!patch_file(path, offsetof(_cmap_image_t, size), &cap, sizeof cap)) return 1;
+        img = cmap_ii_map_file(path);
+        if (cmap_ii_is_mapped(&img) || cmap_ii_size(img)) return 1;
+    }
+
+    c_auto (cmap_uu, map)
+    {
+        stc64_t rng = stc64_init(1);
+        c_forrange (i, 100000) cmap_uu_emplace(&map, stc64_rand(&rng), (double) i);
+        fp = fopen(path, "wb");
+        if (!fp || !cmap_uu_save(&map, fp)) return 1;
+        fclose(fp);
+
+        cmap_uu img = cmap_uu_map_file(path);
+        size_t n = 0;
+        c_foreach (i, cmap_uu, map) n += cmap_uu_contains(&img, i.ref->first);
+        printf("cmap with stored hash: %zu of %zu entries found\n", n, cmap_uu_size(img));
+        cmap_uu_del(&img); /* same as unmap() for a mapped map */
+    }
+
+    c_auto (csmap_ii, tree, empty)
+    {
+        c_forrange (i, int, 1000) csmap_ii_emplace(&tree, i*3, -i);
+        c_forrange (i, int, 100) csmap_ii_erase(&tree, i*6);
+        fp = fopen(path, "wb");
+        if (!fp || !csmap_ii_save(&tree, fp)) return 1;
+        fclose(fp);
+
+        csmap_ii img = csmap_ii_map_file(path);
+        if (!csmap_ii_is_mapped(&img) || csmap_ii_is_mapped(&tree)) return 1;
+        int n = 0, last = -1, sorted = 1;
+        c_foreach (i, csmap_ii, img) {
+            sorted &= i.ref->first > last, last = i.ref->first;
+            n += (*csmap_ii_at(&tree, i.ref->first) == i.ref->second);
+        }
+        printf("csmap: %d of %zu entries found in order: %d, first: %d\n",
+               n, csmap_ii_size(img), sorted, csmap_ii_front(&img)->first);
+        csmap_ii_unmap(&img);
+
+        const size_t head = _csmap_rep(&tree)->head + 10, rep = sizeof(_csmap_image_t);
+        if (!patch_file(path, rep + offsetof(struct csmap_rep, head), &head, sizeof head) ||
+            !patch_file(path, rep + offsetof(struct csmap_rep, cap), &head, sizeof head)) return 1;
+        img = csmap_ii_map_file(path);
+        if (csmap_ii_is_mapped(&img) || csmap_ii_size(img)) return 1;
+
+        fp = fopen(path, "wb");
+        if (!fp || !csmap_ii_save(&empty, fp)) return 1;
+        fclose(fp);
+        img = csmap_ii_map_file(path);
+        printf("empty csmap: %zu\n", csmap_ii_size(img));
+        csmap_ii_clear(&img); /* unmaps it */
+        if (csmap_ii_is_mapped(&img)) return 1;
+    }
+
+    c_auto (csmultimap_ii, multi)
+    {   /* same node size, but the multimap's sequence numbers are no subtree counts */
+        c_forrange (i, int, 100) csmultimap_ii_insert(&multi, i % 10, i);
+        fp = fopen(path, "wb");
+        if (!fp || !csmultimap_ii_save(&multi, fp)) return 1;
+        fclose(fp);
+        if (sizeof(csmultimap_ii_node_t) != sizeof(csmap_io_node_t)) return 1;
+
+        csmap_io ord = csmap_io_map_file(path);
+        if (csmap_io_is_mapped(&ord) || csmap_io_size(ord)) return 1;
+        csmultimap_ii img = csmultimap_ii_map_file(path);
+        printf("csmultimap: %zu, as ordstat csmap: %zu\n", csmultimap_ii_size(img), csmap_io_size(ord));
+        csmultimap_ii_unmap(&img);
+    }
+    remove(path);
+}
@@ -0,0 +1,55 @@
+// A keyword table and a large id set, frozen from a cmap and a cset into perfect hash tables.
+#include <stdio.h>
+#include <stc/cstr.h>
+#include <stc/crandom.h>
+
+#define i_key_str
+#define i_val int
+#define i_tag kw
+#include <stc/cphmap.h>
+
+#define i_key uint64_t
+#define i_tag id
+#include <stc/cphset.h>
+
+int main()
+{
+    static const char* words[] = {"auto", "break", "case", "char", "const", "continue", "default", "do",
+        "double", "else", "enum", "extern", "float", "for", "goto", "if", "inline", "int", "long", "register",
+        "restrict", "return", "short", "signed", "sizeof", "static", "struct", "switch", "typedef", "union",
+        "unsigned", "void", "volatile", "while"};
+    enum { NW = sizeof words/sizeof *words, N = 100000 };
+    int errors = 0;
+
+    c_auto (cmap_kw, m)
+    c_auto (cphmap_kw, keywords)
+    {
+        c_forrange (i, int, NW) cmap_kw_emplace(&m, words[i], i);
+        keywords = cmap_kw_freeze(&m);
+        c_forrange (i, int, NW) errors += *cphmap_kw_at(&keywords, words[i]) != i;
+        static const char* others[] = {"main", "printf", "Int", "", "whilst"};
+        c_forrange (i, 5) errors += cphmap_kw_contains(&keywords, others[i]);
+
+        c_foreach (i, cphmap_kw, keywords) if (i.ref->second < 3)
+            printf("%s: %d\n", i.ref->first.str, i.ref->second);
+        printf("keywords: %zu, buckets: %zu\n", cphmap_kw_size(keywords), cphmap_kw_bucket_count(keywords));
+    }
+
+    stc64_t rng = stc64_init(42);
+    c_auto (cset_id, s)
+    c_auto (cphset_id, ids)
+    {
+        c_forrange (N) cset_id_insert(&s, stc64_rand(&rng) >> 1);
+        ids = cset_id_freeze(&s);
+        errors += cphset_id_size(ids) != cset_id_size(s);
+        c_foreach (i, cset_id, s) errors += !cphset_id_contains(&ids, *i.ref);
+        c_forrange (N) { /* odd ids were never added */
+            uint64_t id = stc64_rand(&rng) | 1;
+            errors += cphset_id_contains(&ids, id) != cset_id_contains(&s, id);
+        }
+        printf("ids: %zu, bits per id for pilots: %.1f\n", cphset_id_size(ids),
+               32.0*cphset_id_bucket_count(ids)/cphset_id_size(ids));
+    }
+    printf("errors: %d\n", errors);
+    return errors != 0;
+}
@@ -0,0 +1,78 @@
+// An inverted index: term id => document ids, as a hash multimap and as a sorted multimap.
+// Each posting is one entry in the map, with no list node of its own.
+#include <stdio.h>
+#include <stc/crandom.h>
+
+#define i_tag post
+#define i_key uint32_t
+#define i_val uint32_t
+#include <stc/cmultimap.h>
+
+#define i_tag post
+#define i_key uint32_t
+#define i_val uint32_t
+#include <stc/csmultimap.h>
+
+enum { DOCS = 20000, TERMS_PER_DOC = 20, VOCAB = 5000 };
+
+static uint32_t term_of(stc64_t* rng) { // skewed: low term ids are frequent
+    uint64_t r = stc64_rand(rng) % VOCAB;
+    return (uint32_t) (r * r / VOCAB);
+}
+
+int main()
+{
+    static size_t df[VOCAB]; // document frequency, counted on the side
+    stc64_t rng = stc64_init(7);
+
+    c_auto (cmultimap_post, hidx)
+    c_auto (csmultimap_post, sidx)
+    {
+        c_forrange (doc, uint32_t, DOCS) {
+            c_forrange (TERMS_PER_DOC) {
+                uint32_t term = term_of(&rng);
+                cmultimap_post_insert(&hidx, term, doc);
+                csmultimap_post_insert(&sidx, term, doc);
+                ++df[term];
+            }
+        }
+        printf("postings: %zu\n", cmultimap_post_size(hidx));
+
+        // Documents of one term: postings of the sorted index come in insertion order.
+        uint32_t term = 42, last = 0;
+        size_t n = 0;
+        csmultimap_post_range_t r = csmultimap_post_equal_range(&sidx, term);
+        c_foreach (i, csmultimap_post, r.first, r.last) {
+            if (i.ref->second < last) return 1;
+            last = i.ref->second, ++n;
+        }
+        printf("term %u: %zu postings\n", term, n);
+
+        // Count all terms in both indexes.
+        c_forrange (t, uint32_t, VOCAB) {
+            if (cmultimap_post_count(&hidx, t) != df[t]) return 1;
+            if (csmultimap_post_count(&sidx, t) != df[t]) return 1;
+        }
+
+        // Drop the most frequent terms, as stop words.
+        size_t dropped = 0;
+        c_forrange (t, uint32_t, 10) {
+            size_t k = cmultimap_post_erase_all(&hidx, t);
+            if (k != csmultimap_post_erase_all(&sidx, t) || k != df[t]) return 1;
+            dropped += k;
+        }
+        printf("dropped %zu stop word postings\n", dropped);
+        if (cmultimap_post_size(hidx) != csmultimap_post_size(sidx)) return 1;
+
+        // The postings of a term in the hash index: same documents as in the sorted index.
+        cmultimap_post_range_t h = cmultimap_post_equal_range(&hidx, term);
+        uint64_t sum = 0;
+        for (cmultimap_post_iter_t i = h.first; i.ref != h.last.ref; cmultimap_post_next_equal(&hidx, &i))
+            sum += i.ref->second;
+        r = csmultimap_post_equal_range(&sidx, term);
+        c_foreach (i, csmultimap_post, r.first, r.last)
+            sum -= i.ref->second;
+        if (sum != 0) return 1;
+    }
+    puts("ok");
+}
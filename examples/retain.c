@@ -0,0 +1,64 @@
+// Expiry sweep: drop all entries older than a cutoff from a cmap, csmap, cvec and cdeq in one pass each.
+#include <stdio.h>
+#include <stc/crandom.h>
+
+typedef struct { int id; int stamp; } Event;
+
+#define i_key int
+#define i_val int
+#include <stc/cmap.h>
+
+#define i_key int
+#define i_val int
+#include <stc/csmap.h>
+
+#define i_val Event
+#define i_cmp c_no_compare
+#define i_tag ev
+#include <stc/cvec.h>
+
+#define i_val int
+#include <stc/cdeq.h>
+
+static bool map_fresh(const cmap_int_value_t* v, void* cutoff) { return v->second >= *(int *) cutoff; }
+static bool smap_fresh(const csmap_int_value_t* v, void* cutoff) { return v->second >= *(int *) cutoff; }
+static bool vec_fresh(const Event* e, void* cutoff) { return e->stamp >= *(int *) cutoff; }
+static bool deq_fresh(const int* stamp, void* cutoff) { return *stamp >= *(int *) cutoff; }
+
+int main()
+{
+    enum { N = 100000 };
+    int cutoff = 30; /* stamps are 0..99: about 30% expire */
+    stc64_t rng = stc64_init(42);
+
+    c_auto (cmap_int, map)
+    c_auto (csmap_int, smap)
+    c_auto (cvec_ev, vec)
+    c_auto (cdeq_int, deq)
+    {
+        c_forrange (i, int, N) {
+            int stamp = (int) (stc64_rand(&rng) % 100);
+            cmap_int_insert(&map, i, stamp);
+            csmap_int_insert(&smap, i, stamp);
+            cvec_ev_push_back(&vec, (Event){i, stamp});
+            cdeq_int_push_back(&deq, stamp);
+        }
+        size_t n1 = cmap_int_retain(&map, map_fresh, &cutoff);
+        size_t n2 = csmap_int_retain(&smap, smap_fresh, &cutoff);
+        size_t n3 = cvec_ev_retain(&vec, vec_fresh, &cutoff);
+        size_t n4 = cdeq_int_retain(&deq, deq_fresh, &cutoff);
+        printf("expired: %zu %zu %zu %zu, left: %zu\n", n1, n2, n3, n4, cmap_int_size(map));
+        csmap_int_compact(&smap); /* give back the expired nodes, and lay out the rest in key order */
+
+        int ok = n1 == n2 && n2 == n3 && n3 == n4 && csmap_int_capacity(smap) == csmap_int_size(smap), last = -1;
+        c_foreach (i, cvec_ev, vec) {
+            cmap_int_value_t* v = cmap_int_get(&map, i.ref->id);
+            ok &= v && v->second == i.ref->stamp && i.ref->stamp >= cutoff && i.ref->id > last;
+            ok &= *csmap_int_at(&smap, i.ref->id) == i.ref->stamp;
+            ok &= *cdeq_int_at(&deq, cvec_ev_index(vec, i)) == i.ref->stamp;
+            last = i.ref->id;
+        }
+        puts(ok ? "all containers agree" : "MISMATCH");
+        if (!ok) return 1;
+    }
+}
@@ -0,0 +1,71 @@
+// Robin Hood maps under a hash with few distinct values: clusters much longer than the
+// 254 displacements the metadata byte can hold, checked against a plain array.
+#include <stdio.h>
+#include <stc/crandom.h>
+
+static uint64_t weak_hash(const int* k, size_t n) { (void)n; return (uint64_t) (*k % 8) * 0x9E3779B97F4A7C15ull; }
+
+#define i_key int
+#define i_val int
+#define i_tag rh
+#define i_hash weak_hash
+#define i_robinhood
+#include <stc/cmap.h>
+
+#define i_key int
+#define i_val int
+#define i_tag rhs
+#define i_hash weak_hash
+#define i_robinhood
+#define i_storehash
+#include <stc/cmap.h>
+
+enum { K = 3000, OPS = 200000 };
+
+static bool keep_rh(const cmap_rh_value_t* v, void* ctx) { (void)ctx; return v->first % 3 != 0; }
+static bool keep_rhs(const cmap_rhs_value_t* v, void* ctx) { (void)ctx; return v->first % 3 != 0; }
+
+#define CHECK_MAP(X, m, ref, r) do { \
+    size_t _n = 0; \
+    c_forrange (_x, int, K) { \
+        _n += ref[_x]; \
+        if ((X##_get(&m, _x) != NULL) != ref[_x]) { \
+            printf(#X ": after %d ops, key %d: expected %d\n", r, _x, ref[_x]); return 1; } \
+    } \
+    if (_n != X##_size(m)) { printf(#X ": wrong size\n"); return 1; } \
+} while (0)
+
+int main()
+{
+    static char ref[K];
+    stc64_t rng = stc64_init(5);
+
+    c_auto (cmap_rh, m1)
+    c_auto (cmap_rhs, m2)
+    {
+        c_forrange (r, int, OPS) {
+            int k = (int) (stc64_rand(&rng) % K);
+            if (stc64_rand(&rng) % 3) {
+                cmap_rh_insert(&m1, k, r);
+                cmap_rhs_insert(&m2, k, r);
+                ref[k] = 1;
+            } else {
+                if ((int) cmap_rh_erase(&m1, k) != ref[k] || (int) cmap_rhs_erase(&m2, k) != ref[k]) return 1;
+                ref[k] = 0;
+            }
+            if (r % 5000 == 0) {
+                CHECK_MAP(cmap_rh, m1, ref, r);
+                CHECK_MAP(cmap_rhs, m2, ref, r);
+            }
+        }
+        /* retain() moves the remaining entries of each cluster back */
+        cmap_rh_retain(&m1, keep_rh, NULL);
+        cmap_rhs_retain(&m2, keep_rhs, NULL);
+        c_forrange (x, int, K) if (x % 3 == 0) ref[x] = 0;
+        CHECK_MAP(cmap_rh, m1, ref, OPS);
+        CHECK_MAP(cmap_rhs, m2, ref, OPS);
+
+        chash_stats_t st = cmap_rh_stats(&m1);
+        printf("size %zu, longest probe %zu: ok\n", cmap_rh_size(m1), st.max_probe_length);
+    }
+}
@@ -0,0 +1,55 @@
+// Many tiny attribute maps: with i_inline, maps of up to 4 entries allocate nothing.
+#include <stdio.h>
+#include <stc/crandom.h>
+#include <stc/cstr.h>
+
+#define i_key_str
+#define i_val int
+#define i_tag attr
+#define i_inline 4
+#include <stc/cmap.h>
+
+#define i_key_str
+#define i_val int
+#define i_tag plain
+#include <stc/cmap.h>
+
+static const char* names[] = {"id", "width", "height", "depth", "color", "weight"};
+
+int main()
+{
+    enum { N = 10000 };
+    stc64_t rng = stc64_init(12345);
+    cmap_attr* objs = c_new_n(cmap_attr, N);
+    cmap_plain* refs = c_new_n(cmap_plain, N);
+    size_t tables = 0, entries = 0, errors = 0;
+
+    c_forrange (i, N) {
+        objs[i] = cmap_attr_init(), refs[i] = cmap_plain_init();
+        int n = (int) (stc64_rand(&rng) % 7);
+        c_forrange (j, int, n) {
+            const char* name = names[stc64_rand(&rng) % 6];
+            cmap_attr_emplace(&objs[i], name, j);
+            cmap_plain_emplace(&refs[i], name, j);
+        }
+        if (stc64_rand(&rng) % 4 == 0) {
+            cmap_attr_erase(&objs[i], "id");
+            cmap_plain_erase(&refs[i], "id");
+            cmap_attr_shrink_to_fit(&objs[i]);
+        }
+    }
+    c_forrange (i, N) {
+        tables += cmap_attr_bucket_count(objs[i]) != 0;
+        entries += cmap_attr_size(objs[i]);
+        errors += cmap_attr_size(objs[i]) != cmap_plain_size(refs[i]);
+        c_foreach (j, cmap_plain, refs[i]) {
+            cmap_attr_value_t* v = cmap_attr_get(&objs[i], j.ref->first.str);
+            errors += !v || v->second != j.ref->second;
+        }
+        cmap_attr_del(&objs[i]);
+        cmap_plain_del(&refs[i]);
+    }
+    c_free(objs); c_free(refs);
+    printf("%d maps, %zu entries, %zu with a table, %zu errors\n", (int) N, entries, tables, errors);
+    return errors != 0;
+}
@@ -0,0 +1,58 @@
+// A cache of large records: with i_soa, lookups probe a dense array of keys, apart from the records.
+#include <stdio.h>
+#include <string.h>
+#include <stc/crandom.h>
+
+typedef struct { uint64_t id; int hits; char payload[240]; } Record;
+
+#define i_tag rec
+#define i_key uint64_t
+#define i_val Record
+#include <stc/cmap.h>
+
+#define i_tag soa
+#define i_key uint64_t
+#define i_val Record
+#define i_soa
+#include <stc/cmap.h>
+
+static bool is_hot(const cmap_soa_value_t* key, void* map) { return cmap_soa_mapped((cmap_soa *) map, key)->hits > 0; }
+
+int main()
+{
+    enum { N = 20000 };
+    stc64_t rng = stc64_init(7);
+    Record r = {0};
+
+    c_auto (cmap_rec, pairs)
+    c_auto (cmap_soa, split)
+    {
+        c_forrange (i, N) {
+            r.id = stc64_rand(&rng);
+            sprintf(r.payload, "record %zu", (size_t) i);
+            cmap_rec_insert(&pairs, r.id, r);
+            cmap_soa_insert(&split, r.id, r);
+        }
+        /* Every other key queried is absent, and half of the records are hit. */
+        stc64_t q = stc64_init(7);
+        size_t found = 0;
+        c_forrange (i, N) {
+            uint64_t key = i & 1 ? stc64_rand(&rng) : stc64_rand(&q);
+            cmap_soa_value_t* k = cmap_soa_get(&split, key);
+            if (k) ++cmap_soa_mapped(&split, k)->hits, ++found;
+            if (cmap_rec_get(&pairs, key)) ++cmap_rec_at(&pairs, key)->hits;
+        }
+        printf("found %zu of %d, size %zu\n", found, N, cmap_soa_size(split));
+
+        int ok = 1;
+        c_foreach (i, cmap_soa, split) {
+            const Record* a = cmap_soa_mapped(&split, i.ref), *b = cmap_rec_at(&pairs, *i.ref);
+            ok &= a->id == *i.ref && a->hits == b->hits && !strcmp(a->payload, b->payload);
+        }
+        size_t erased = cmap_soa_retain(&split, is_hot, &split);
+        c_foreach (i, cmap_soa, split) ok &= cmap_soa_mapped(&split, i.ref)->hits == 1;
+        printf("cold records erased: %zu, left: %zu\n", erased, cmap_soa_size(split));
+        puts(ok && found == N/2 && erased == N/2 ? "split layout agrees" : "MISMATCH");
+        if (!(ok && found == N/2 && erased == N/2)) return 1;
+    }
+}
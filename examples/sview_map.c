@@ -0,0 +1,42 @@
+// Look up string keys by csview: the keys are slices of one buffer, never NUL-terminated copies.
+#include <stdio.h>
+#include <stc/csview.h>
+
+#define i_key_str
+#define i_val int
+#include <stc/cmap.h>
+
+#define i_key_str
+#define i_val int
+#include <stc/csmap.h>
+
+int main()
+{
+    const char* text = "the quick brown fox jumps over the lazy dog the end";
+    csview sep = c_sv(" ");
+
+    c_auto (cmap_str, counts)
+    c_auto (csmap_str, sorted)
+    {
+        csview tok = csview_first_token(csview_from(text), sep);
+        for (; tok.size; tok = csview_next_token(csview_from(text), sep, tok)) {
+            ++cmap_str_emplace_v(&counts, tok, 0).ref->second;
+            ++csmap_str_emplace_v(&sorted, tok, 0).ref->second;
+        }
+        csview the = csview_from_n(text, 3), fox = csview_from_n(text + 16, 3);
+        printf("the: %d, fox: %d, cat: %d\n", *cmap_str_at_v(&counts, the),
+               cmap_str_get_v(&counts, fox)->second, cmap_str_contains_v(&counts, c_sv("cat")));
+
+        cmap_str_erase_v(&counts, the);
+        csmap_str_erase_v(&sorted, the);
+        printf("unique: %zu, sorted: %zu, has \"the\": %d\n", cmap_str_size(counts),
+               csmap_str_size(sorted), csmap_str_contains(&sorted, "the"));
+        printf("first >= \"f\":");
+        c_foreach (i, csmap_str, csmap_str_lower_bound_v(&sorted, c_sv("f")), csmap_str_end(&sorted))
+            printf(" %s", i.ref->first.str);
+        puts("");
+
+        c_foreach (i, cmap_str, counts)
+            if (csmap_str_get_v(&sorted, cstr_to_v(&i.ref->first))->second != i.ref->second) return 1;
+    }
+}
@@ -0,0 +1,251 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Tyge Løvset, NORCE, www.norceresearch.no
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Blocked Bloom filter: every key sets and tests k bits within a single 64-byte block.
+/*
+#include <stdio.h>
+
+#define i_key int
+#include <stc/cbloom.h>
+
+int main(void) {
+    c_autovar (cbloom_int f = cbloom_int_with_capacity(1000, 0.01), cbloom_int_del(&f))
+    {
+        c_forrange (i, int, 1000) cbloom_int_add(&f, i*3);
+        printf("%d %d\n", cbloom_int_maybe_contains(&f, 300),   // 1
+                          cbloom_int_maybe_contains(&f, 301));  // 0, or 1 with 1% probability
+        printf("about %zu keys\n", cbloom_int_estimate_count(&f));
+    }
+}
+*/
+#ifndef CBLOOM_H_INCLUDED
+#define CBLOOM_H_INCLUDED
+#include "ccommon.h"
+#include "cbits.h"
+#include <math.h>
+
+#define _cbloom_BLOCK 512 /* bits per block: one cache line */
+#define _cbloom_MAXK 16 /* max. bits per key */
+#define _cbloom_BATCH 16 /* lookups in flight in maybe_contains_n() */
+
+#if defined __AVX2__
+  #include <immintrin.h>
+#elif defined __SSE4_1__
+  #include <smmintrin.h>
+#endif
+
+/* Spread a hash: the upper half selects the block, the lower half the bits within it. */
+STC_INLINE uint64_t _cbloom_mix(uint64_t h) { return (h ^ (h >> 32))*0x9e3779b97f4a7c15; }
+
+STC_INLINE size_t _cbloom_block(uint64_t h, size_t nblocks)
+    { return (size_t) (((h >> 32)*(uint64_t) nblocks) >> 32); }
+
+/* The k bits of a key, as a mask of the 8 words of a block. */
+STC_INLINE void _cbloom_mask(uint64_t h, unsigned k, uint64_t m[8]) {
+    uint32_t x = (uint32_t) h | 1;
+    memset(m, 0, 8*sizeof *m);
+    while (k--) {
+        x *= 0x9e3779b9u;
+        m[x >> 29] |= 1ull << (x >> 23 & 63);
+    }
+}
+
+/* Are all bits of mask m set in block b? */
+STC_INLINE bool _cbloom_test(const uint64_t* b, const uint64_t m[8]) {
+#if defined __AVX2__
+    return _mm256_testc_si256(_mm256_load_si256((const __m256i *) b), _mm256_loadu_si256((const __m256i *) m)) &
+           _mm256_testc_si256(_mm256_load_si256((const __m256i *) (b + 4)), _mm256_loadu_si256((const __m256i *) (m + 4)));
+#elif defined __SSE4_1__
+    int r = 1;
+    for (int i = 0; i < 8; i += 2)
+        r &= _mm_testc_si128(_mm_load_si128((const __m128i *) (b + i)), _mm_loadu_si128((const __m128i *) (m + i)));
+    return r;
+#else
+    uint64_t r = 0;
+    for (int i = 0; i < 8; ++i) r |= m[i] & ~b[i];
+    return r == 0;
+#endif
+}
+
+/* Expected false positive rate with n keys in nblocks blocks, k bits per key. The number of keys
+   in the block of a query is Poisson distributed, and each block is a small Bloom filter. */
+STC_INLINE double cbloom_fpr(size_t n, size_t nblocks, unsigned k) {
+    if (n == 0 || nblocks == 0) return n ? 1.0 : 0.0;
+    const double lam = (double) n / (double) nblocks, sd = sqrt(lam);
+    const double q = k*log1p(-1.0/_cbloom_BLOCK);
+    size_t j = lam > 10*sd + 10 ? (size_t) (lam - 10*sd - 10) : 0, end = (size_t) (lam + 10*sd + 10);
+    double sum = 0.0, p = exp(j*log(lam) - lam - lgamma(j + 1.0)); /* P(j keys) */
+    for (; j <= end; p *= lam/++j)
+        sum += p*pow(-expm1(j*q), k);
+    return sum;
+}
+
+/* Fewest blocks that reach the rate fpr with n keys, and the k for it. */
+STC_INLINE void _cbloom_size(size_t n, double fpr, size_t* nblocks, unsigned* k) {
+    fpr = fpr < 1e-12 ? 1e-12 : fpr > 0.5 ? 0.5 : fpr;
+    const double ln2 = 0.69314718055994531, kopt = -log(fpr) / ln2;
+    const size_t maxblocks = (size_t) 1 << (sizeof(size_t) < 8 ? 31 - 6 : 32);
+    unsigned h = kopt > 4 ? (unsigned) kopt - 3 : 1, hend = (unsigned) kopt + 3;
+    if (n == 0) n = 1;
+    if (hend > _cbloom_MAXK) hend = _cbloom_MAXK;
+    if (h > hend) h = hend;
+    *nblocks = maxblocks, *k = h;
+    for (; h <= hend; ++h) {
+        size_t lo = 1, hi = 1, mid;
+        while (hi < *nblocks && cbloom_fpr(n, hi, h) > fpr) lo = hi + 1, hi *= 2;
+        if (hi > *nblocks) hi = *nblocks;
+        while (lo < hi) {
+            mid = lo + (hi - lo)/2;
+            if (cbloom_fpr(n, mid, h) > fpr) lo = mid + 1;
+            else hi = mid;
+        }
+        if (hi < *nblocks && cbloom_fpr(n, hi, h) <= fpr) *nblocks = hi, *k = h;
+    }
+}
+#endif // CBLOOM_H_INCLUDED
+
+#ifndef i_prefix
+#define i_prefix cbloom_
+#endif
+#include "template.h"
+
+typedef i_key cx_key_t;
+typedef i_keyraw cx_rawkey_t;
+typedef i_keyraw cx_rawvalue_t;
+
+/* bits holds one spare block, so that the blocks can start on a cache line. */
+typedef struct { cbits bits; uint64_t* _blocks; size_t nblocks; unsigned k; } Self;
+
+STC_API Self            cx_memb(_with_blocks)(size_t nblocks, unsigned k);
+STC_API Self            cx_memb(_clone)(Self bf);
+STC_API size_t          cx_memb(_maybe_contains_n)(const Self* self, const cx_rawkey_t keys[], size_t n, bool out[]);
+STC_API void            cx_memb(_union)(Self* self, const Self* other);
+STC_API size_t          cx_memb(_estimate_count)(const Self* self);
+
+STC_INLINE Self         cx_memb(_init)(void) { Self bf = {{NULL, 0}, NULL, 0, 0}; return bf; }
+STC_INLINE void         cx_memb(_del)(Self* self) { cbits_del(&self->bits); }
+STC_INLINE void         cx_memb(_clear)(Self* self) { if (self->nblocks) memset(self->_blocks, 0, self->nblocks*64); }
+STC_INLINE size_t       cx_memb(_block_count)(Self bf) { return bf.nblocks; }
+STC_INLINE unsigned     cx_memb(_hash_count)(Self bf) { return bf.k; }
+STC_INLINE double       cx_memb(_fpr)(const Self* self, size_t n) { return cbloom_fpr(n, self->nblocks, self->k); }
+
+STC_INLINE Self
+cx_memb(_with_capacity)(size_t n, double fpr) {
+    size_t _nblocks; unsigned _k;
+    _cbloom_size(n, fpr, &_nblocks, &_k);
+    return cx_memb(_with_blocks)(_nblocks, _k);
+}
+
+STC_INLINE uint64_t
+cx_memb(_hash_)(const cx_rawkey_t* rkeyptr) { return _cbloom_mix(i_hash(rkeyptr, sizeof *rkeyptr)); }
+
+STC_INLINE void
+cx_memb(_add)(Self* self, i_keyraw rkey) {
+    assert(self->nblocks && "cbloom: created by init(), not with_capacity()");
+    uint64_t _m[8], _h = cx_memb(_hash_)(&rkey);
+    uint64_t* _b = self->_blocks + 8*_cbloom_block(_h, self->nblocks);
+    _cbloom_mask(_h, self->k, _m);
+    for (int i = 0; i < 8; ++i) _b[i] |= _m[i];
+}
+
+/* false: rkey was never added. true: it probably was. */
+STC_INLINE bool
+cx_memb(_maybe_contains)(const Self* self, i_keyraw rkey) {
+    if (self->nblocks == 0) return false;
+    uint64_t _m[8], _h = cx_memb(_hash_)(&rkey);
+    _cbloom_mask(_h, self->k, _m);
+    return _cbloom_test(self->_blocks + 8*_cbloom_block(_h, self->nblocks), _m);
+}
+
+/* -------------------------- IMPLEMENTATION ------------------------- */
+
+#if !defined(STC_HEADER) || defined(STC_IMPLEMENTATION) || defined(i_imp)
+
+STC_DEF Self
+cx_memb(_with_blocks)(size_t nblocks, unsigned k) {
+    if (nblocks == 0) nblocks = 1;
+    assert((uint64_t) nblocks <= (uint64_t) 1 << 32 && "cbloom: too many blocks");
+    Self bf = {cbits_with_size((nblocks + 1)*_cbloom_BLOCK, false), NULL, nblocks,
+               k < 1 ? 1 : k > _cbloom_MAXK ? _cbloom_MAXK : k};
+    bf._blocks = (uint64_t *) (((uintptr_t) bf.bits.data64 + 63) & ~(uintptr_t) 63);
+    return bf;
+}
+
+STC_DEF Self
+cx_memb(_clone)(Self bf) {
+    if (bf.nblocks == 0) return cx_memb(_init)();
+    Self clone = cx_memb(_with_blocks)(bf.nblocks, bf.k);
+    memcpy(clone._blocks, bf._blocks, bf.nblocks*64);
+    return clone;
+}
+
+/* Hash the whole batch and prefetch the blocks first, so that the cache misses overlap. */
+STC_DEF size_t
+cx_memb(_maybe_contains_n)(const Self* self, const cx_rawkey_t keys[], size_t n, bool out[]) {
+    uint64_t _h[_cbloom_BATCH], _m[8];
+    size_t i, j, c, found = 0;
+    if (self->nblocks == 0) {
+        if (out) memset(out, 0, n*sizeof *out);
+        return 0;
+    }
+    for (i = 0; i < n; i += c) {
+        c = n - i < _cbloom_BATCH ? n - i : _cbloom_BATCH;
+        for (j = 0; j < c; ++j) {
+            _h[j] = cx_memb(_hash_)(keys + i + j);
+            c_prefetch(self->_blocks + 8*_cbloom_block(_h[j], self->nblocks));
+        }
+        for (j = 0; j < c; ++j) {
+            _cbloom_mask(_h[j], self->k, _m);
+            bool _r = _cbloom_test(self->_blocks + 8*_cbloom_block(_h[j], self->nblocks), _m);
+            found += _r;
+            if (out) out[i + j] = _r;
+        }
+    }
+    return found;
+}
+
+/* Both filters must have the same number of blocks and bits per key. */
+STC_DEF void
+cx_memb(_union)(Self* self, const Self* other) {
+    assert(self->nblocks == other->nblocks && self->k == other->k);
+    const size_t n = self->nblocks*8;
+    for (size_t i = 0; i < n; ++i) self->_blocks[i] |= other->_blocks[i];
+}
+
+/* Each block is estimated as a Bloom filter of its own, from the number of bits set. */
+STC_DEF size_t
+cx_memb(_estimate_count)(const Self* self) {
+    const double q = self->k*log1p(-1.0/_cbloom_BLOCK);
+    double n = 0.0;
+    for (size_t i = 0; i < self->nblocks; ++i) {
+        const uint64_t* _b = self->_blocks + 8*i;
+        size_t x = 0;
+        for (int j = 0; j < 8; ++j) x += cpopcount64(_b[j]);
+        if (x == _cbloom_BLOCK) x = _cbloom_BLOCK - 1;
+        n += log1p(-(double) x/_cbloom_BLOCK) / q;
+    }
+    return (size_t) (n + 0.5);
+}
+
+#endif // TEMPLATED IMPLEMENTATION
+#include "template.h"
@@ -0,0 +1,642 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Tyge Løvset, NORCE, www.norceresearch.no
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Sorted/Ordered set and map - implemented as a B+ tree: wide nodes, entries in linked leaves.
+/*
+#include <stdio.h>
+#include <stc/cstr.h>
+
+#define i_tag sx  // Sorted map<cstr, double>
+#define i_key_str
+#define i_val double
+#include <stc/cbtmap.h>
+
+int main(void) {
+    c_autovar (cbtmap_sx m = cbtmap_sx_init(), cbtmap_sx_del(&m))
+    {
+        cbtmap_sx_emplace(&m, "Testing one", 1.234);
+        cbtmap_sx_emplace(&m, "Testing two", 12.34);
+        cbtmap_sx_emplace(&m, "Testing three", 123.4);
+
+        cbtmap_sx_value_t *v = cbtmap_sx_get(&m, "Testing five"); // NULL
+        double num = *cbtmap_sx_at(&m, "Testing one");
+        cbtmap_sx_emplace_or_assign(&m, "Testing three", 1000.0); // update
+        cbtmap_sx_erase(&m, "Testing two");
+
+        c_foreach (i, cbtmap_sx, m)
+            printf("map %s: %g\n", i.ref->first.str, i.ref->second);
+    }
+}
+*/
+
+#ifndef CBTMAP_H_INCLUDED
+#include "ccommon.h"
+#include "forward.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define _cbtmap_NODE 512 /* target node size in bytes */
+#define _cbtmap_MAXH 40 /* max. inner levels: inner nodes have at least 4 children, the root 2 */
+/* entries per node: _cbtmap_NODE bytes, but between 8 and 32 */
+#define _cbtmap_width(size) ((size)*32 <= _cbtmap_NODE ? 32 : (size)*8 >= _cbtmap_NODE ? 8 : _cbtmap_NODE/(size))
+#endif // CBTMAP_H_INCLUDED
+
+#ifndef i_prefix
+#define i_prefix cbtmap_
+#endif
+#ifdef i_isset
+  #define cx_MAP_ONLY c_false
+  #define cx_SET_ONLY c_true
+  #define cx_keyref(vp) (vp)
+#else
+  #define cx_MAP_ONLY c_true
+  #define cx_SET_ONLY c_false
+  #define cx_keyref(vp) (&(vp)->first)
+#endif
+#include "template.h"
+#if defined i_multi || defined i_persist
+  #error cbtmap does not support i_multi or i_persist
+#endif
+#ifdef i_key_str
+  #include "csview.h"
+#endif
+
+#ifndef i_fwd
+cx_deftypes(_c_btree_types, Self, i_key, i_val, cx_MAP_ONLY, cx_SET_ONLY);
+#endif
+
+cx_MAP_ONLY( struct cx_value_t {
+    cx_key_t first;
+    cx_mapped_t second;
+}; )
+
+#define cx_LEAF _cbtmap_width(sizeof(cx_value_t))
+#define cx_INNER _cbtmap_width(sizeof(cx_key_t) + sizeof(void*))
+#define cx_leaf_t cx_memb(_leaf_t)
+#define cx_inner_t cx_memb(_inner_t)
+
+/* A leaf holds 1/2 to 1 times cx_LEAF entries (the root leaf fewer), an inner node 1/2 to 1
+   times cx_INNER children. child[i] has the keys k where keys[i-1] <= k < keys[i]. Both have
+   room for one entry more than that, which is split off before the insert returns. */
+struct cx_leaf_t {
+    uint16_t n;
+    cx_leaf_t* next;
+    cx_value_t values[cx_LEAF + 1];
+};
+typedef struct cx_inner_t {
+    uint16_t n; /* keys: n + 1 children */
+    cx_key_t keys[cx_INNER];
+    void* child[cx_INNER + 1];
+} cx_inner_t;
+
+typedef i_keyraw cx_rawkey_t;
+typedef i_valraw cx_memb(_rawmapped_t);
+typedef cx_SET_ONLY( i_keyraw )
+        cx_MAP_ONLY( struct { i_keyraw first; i_valraw second; } )
+        cx_rawvalue_t;
+
+/* Keys are looked up through cx_lookup_t. String keys use csview, and are
+   ordered by memcmp over the shorter length, then by length, like strcmp. */
+#ifdef i_key_str
+  #define cx_lookup_t csview
+  #define cx_lookup(rkey) csview_from(rkey)
+  #define cx_lookup_key(keyp) cstr_to_v(keyp)
+#else
+  #define cx_lookup_t cx_rawkey_t
+  #define cx_lookup(rkey) (rkey)
+  #define cx_lookup_key(keyp) i_keyto(keyp)
+#endif
+
+STC_API Self            cx_memb(_clone)(Self tree);
+STC_API void            cx_memb(_del)(Self* self);
+STC_API cx_value_t*     cx_memb(_find_it_)(const Self* self, const cx_lookup_t* keyptr, cx_iter_t* out);
+STC_API cx_iter_t       cx_memb(_lower_bound_)(const Self* self, const cx_lookup_t* keyptr);
+STC_API cx_value_t*     cx_memb(_back)(const Self* self);
+STC_API int             cx_memb(_erase_)(Self* self, const cx_lookup_t* keyptr);
+STC_API cx_iter_t       cx_memb(_erase_at)(Self* self, cx_iter_t it);
+STC_API cx_iter_t       cx_memb(_erase_range)(Self* self, cx_iter_t it1, cx_iter_t it2);
+STC_API cx_result_t     cx_memb(_insert_key_)(Self* self, const cx_lookup_t* keyptr);
+
+STC_INLINE Self         cx_memb(_init)(void) { Self tree = {NULL, NULL, 0, 0}; return tree; }
+STC_INLINE bool         cx_memb(_empty)(Self tree) { return tree.size == 0; }
+STC_INLINE size_t       cx_memb(_size)(Self tree) { return tree.size; }
+STC_INLINE size_t       cx_memb(_height)(Self tree) { return tree.root ? tree._height + 1 : 0; }
+STC_INLINE void         cx_memb(_clear)(Self* self) { cx_memb(_del)(self); *self = cx_memb(_init)(); }
+STC_INLINE void         cx_memb(_swap)(Self* a, Self* b) { c_swap(Self, *a, *b); }
+STC_INLINE cx_value_t*  cx_memb(_front)(const Self* self) { return self->_first->values; }
+STC_INLINE cx_value_t*  cx_memb(_find_it)(const Self* self, i_keyraw rkey, cx_iter_t* out)
+                            { cx_lookup_t key = cx_lookup(rkey); return cx_memb(_find_it_)(self, &key, out); }
+STC_INLINE cx_iter_t    cx_memb(_lower_bound)(const Self* self, i_keyraw rkey)
+                            { cx_lookup_t key = cx_lookup(rkey); return cx_memb(_lower_bound_)(self, &key); }
+STC_INLINE int          cx_memb(_erase)(Self* self, i_keyraw rkey)
+                            { cx_lookup_t key = cx_lookup(rkey); return cx_memb(_erase_)(self, &key); }
+STC_INLINE cx_result_t  cx_memb(_insert_entry_)(Self* self, i_keyraw rkey)
+                            { cx_lookup_t key = cx_lookup(rkey); return cx_memb(_insert_key_)(self, &key); }
+STC_INLINE bool         cx_memb(_contains)(const Self* self, i_keyraw rkey)
+                            { cx_iter_t it; return cx_memb(_find_it)(self, rkey, &it) != NULL; }
+STC_INLINE cx_value_t*  cx_memb(_get)(const Self* self, i_keyraw rkey)
+                            { cx_iter_t it; return cx_memb(_find_it)(self, rkey, &it); }
+
+STC_INLINE void
+cx_memb(_copy)(Self *self, Self other) {
+    if (self->root == other.root) return;
+    cx_memb(_del)(self); *self = cx_memb(_clone)(other);
+}
+
+STC_INLINE cx_rawvalue_t
+cx_memb(_value_toraw)(cx_value_t* val) {
+    return cx_SET_ONLY( i_keyto(val) )
+           cx_MAP_ONLY( c_make(cx_rawvalue_t){i_keyto(&val->first), i_valto(&val->second)} );
+}
+
+STC_INLINE void
+cx_memb(_value_del)(cx_value_t* val) {
+    i_keydel(cx_keyref(val));
+    cx_MAP_ONLY( i_valdel(&val->second); )
+}
+
+STC_INLINE void
+cx_memb(_value_clone)(cx_value_t* dst, cx_value_t* val) {
+    *cx_keyref(dst) = i_keyfrom(i_keyto(cx_keyref(val)));
+    cx_MAP_ONLY( dst->second = i_valfrom(i_valto(&val->second)); )
+}
+
+STC_INLINE int
+cx_memb(_cmp_key_)(const cx_key_t* key, const cx_lookup_t* keyptr) {
+#ifdef i_key_str
+    const size_t n = cstr_size(*key);
+    const int c = memcmp(key->str, keyptr->str, n < keyptr->size ? n : keyptr->size);
+    return c ? c : (n > keyptr->size) - (n < keyptr->size);
+#else
+    cx_rawkey_t raw = i_keyto(key);
+    return i_cmp(&raw, keyptr);
+#endif
+}
+
+STC_INLINE int
+cx_memb(_cmp_)(const cx_value_t* val, const cx_lookup_t* keyptr)
+    { return cx_memb(_cmp_key_)(cx_keyref(val), keyptr); }
+
+cx_MAP_ONLY(
+    STC_API cx_result_t cx_memb(_insert_or_assign)(Self* self, i_key key, i_val mapped);
+    STC_API cx_result_t cx_memb(_emplace_or_assign)(Self* self, i_keyraw rkey, i_valraw rmapped);
+
+    STC_INLINE cx_result_t
+    cx_memb(_put)(Self* self, i_key key, i_val mapped)
+        { return cx_memb(_insert_or_assign)(self, key, mapped); }
+
+    STC_INLINE cx_mapped_t*
+    cx_memb(_at)(const Self* self, i_keyraw rkey)
+        { cx_iter_t it; return &cx_memb(_find_it)(self, rkey, &it)->second; }
+)
+
+STC_INLINE cx_iter_t
+cx_memb(_find)(const Self* self, i_keyraw rkey) {
+    cx_iter_t it;
+    cx_memb(_find_it)(self, rkey, &it);
+    return it;
+}
+
+STC_INLINE cx_result_t
+cx_memb(_emplace)(Self* self, i_keyraw rkey cx_MAP_ONLY(, i_valraw rmapped)) {
+    cx_result_t res = cx_memb(_insert_entry_)(self, rkey);
+    if (res.inserted) {
+        *cx_keyref(res.ref) = i_keyfrom(rkey);
+        cx_MAP_ONLY(res.ref->second = i_valfrom(rmapped);)
+    }
+    return res;
+}
+
+STC_INLINE cx_result_t
+cx_memb(_insert)(Self* self, i_key key cx_MAP_ONLY(, i_val mapped)) {
+    cx_result_t res = cx_memb(_insert_entry_)(self, i_keyto(&key));
+    if (res.inserted) { *cx_keyref(res.ref) = key; cx_MAP_ONLY( res.ref->second = mapped; )}
+    else              { i_keydel(&key); cx_MAP_ONLY( i_valdel(&mapped); )}
+    return res;
+}
+
+#ifdef i_key_str
+/* Lookups by csview: no strlen() of the key, nor a NUL-terminated copy. */
+STC_INLINE cx_iter_t
+cx_memb(_find_v)(const Self* self, csview key)
+    { cx_iter_t it; cx_memb(_find_it_)(self, &key, &it); return it; }
+
+STC_INLINE cx_value_t*
+cx_memb(_get_v)(const Self* self, csview key)
+    { cx_iter_t it; return cx_memb(_find_it_)(self, &key, &it); }
+
+STC_INLINE bool
+cx_memb(_contains_v)(const Self* self, csview key)
+    { cx_iter_t it; return cx_memb(_find_it_)(self, &key, &it) != NULL; }
+
+cx_MAP_ONLY(
+    STC_INLINE cx_mapped_t*
+    cx_memb(_at_v)(const Self* self, csview key)
+        { cx_iter_t it; return &cx_memb(_find_it_)(self, &key, &it)->second; }
+)
+
+STC_INLINE cx_iter_t
+cx_memb(_lower_bound_v)(const Self* self, csview key)
+    { return cx_memb(_lower_bound_)(self, &key); }
+
+STC_INLINE cx_result_t
+cx_memb(_emplace_v)(Self* self, csview key cx_MAP_ONLY(, i_valraw rmapped)) {
+    cx_result_t res = cx_memb(_insert_key_)(self, &key);
+    if (res.inserted) {
+        *cx_keyref(res.ref) = cstr_from_v(key);
+        cx_MAP_ONLY(res.ref->second = i_valfrom(rmapped);)
+    }
+    return res;
+}
+
+STC_INLINE int
+cx_memb(_erase_v)(Self* self, csview key) { return cx_memb(_erase_)(self, &key); }
+#endif
+
+/* Move it to the first entry of leaf lf, or to the end if lf is NULL. */
+STC_INLINE void
+cx_memb(_enter_)(cx_iter_t* it, cx_leaf_t* lf) {
+    it->_leaf = lf;
+    if (lf) it->ref = lf->values, it->_end = lf->values + lf->n;
+    else it->ref = NULL;
+}
+
+STC_INLINE cx_iter_t
+cx_memb(_begin)(const Self* self) {
+    cx_iter_t it;
+    cx_memb(_enter_)(&it, self->_first);
+    return it;
+}
+
+STC_INLINE cx_iter_t
+cx_memb(_end)(const Self* self) {
+    (void)self;
+    return c_make(cx_iter_t){.ref = NULL};
+}
+
+STC_INLINE void
+cx_memb(_next)(cx_iter_t* it)
+    { if (++it->ref == it->_end) cx_memb(_enter_)(it, it->_leaf->next); }
+
+STC_INLINE cx_iter_t
+cx_memb(_advance)(cx_iter_t it, size_t n) {
+    while (it.ref && n >= (size_t) (it._end - it.ref)) { /* whole leaves */
+        n -= it._end - it.ref;
+        cx_memb(_enter_)(&it, it._leaf->next);
+    }
+    if (it.ref) it.ref += n;
+    return it;
+}
+
+/* -------------------------- IMPLEMENTATION ------------------------- */
+#if !defined(STC_HEADER) || defined(STC_IMPLEMENTATION) || defined(i_imp)
+
+/* Index of the child of in that may hold the key: the number of keys <= key. */
+STC_INLINE int
+cx_memb(_child_pos_)(const cx_inner_t* in, const cx_lookup_t* keyptr) {
+    int lo = 0, hi = in->n;
+    while (lo < hi) {
+        const int mid = (lo + hi) >> 1;
+        if (cx_memb(_cmp_key_)(&in->keys[mid], keyptr) <= 0) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
+
+/* Index of the first entry of lf >= key. */
+STC_INLINE int
+cx_memb(_leaf_pos_)(const cx_leaf_t* lf, const cx_lookup_t* keyptr) {
+    int lo = 0, hi = lf->n;
+    while (lo < hi) {
+        const int mid = (lo + hi) >> 1;
+        if (cx_memb(_cmp_)(&lf->values[mid], keyptr) < 0) lo = mid + 1; else hi = mid;
+    }
+    return lo;
+}
+
+/* The leaf that may hold the key. With path, also the inner nodes and child indices on the way. */
+STC_INLINE cx_leaf_t*
+cx_memb(_descend_)(const Self* self, const cx_lookup_t* keyptr, cx_inner_t** path, int* pidx) {
+    void* nd = self->root;
+    for (int h = 0; h < self->_height; ++h) {
+        cx_inner_t* in = (cx_inner_t *) nd;
+        const int i = cx_memb(_child_pos_)(in, keyptr);
+        if (path) path[h] = in, pidx[h] = i;
+        nd = in->child[i];
+    }
+    return (cx_leaf_t *) nd;
+}
+
+STC_INLINE cx_key_t
+cx_memb(_key_clone_)(const cx_key_t* key) { return i_keyfrom(i_keyto(key)); }
+
+#ifndef i_key_str
+STC_INLINE cx_key_t
+cx_memb(_key_from_)(const cx_lookup_t* keyptr) { return i_keyfrom(*keyptr); }
+#else
+STC_INLINE cx_key_t
+cx_memb(_key_from_)(const cx_lookup_t* keyptr) { return cstr_from_v(*keyptr); }
+#endif
+
+cx_MAP_ONLY(
+    STC_DEF cx_result_t
+    cx_memb(_insert_or_assign)(Self* self, i_key key, i_val mapped) {
+        cx_result_t res = cx_memb(_insert_entry_)(self, i_keyto(&key));
+        if (res.inserted) res.ref->first = key;
+        else {i_keydel(&key); i_valdel(&res.ref->second); }
+        res.ref->second = mapped; return res;
+    }
+
+    STC_DEF cx_result_t
+    cx_memb(_emplace_or_assign)(Self* self, i_keyraw rkey, i_valraw rmapped) {
+        cx_result_t res = cx_memb(_insert_entry_)(self, rkey);
+        if (res.inserted) res.ref->first = i_keyfrom(rkey);
+        else i_valdel(&res.ref->second);
+        res.ref->second = i_valfrom(rmapped); return res;
+    }
+)
+
+STC_DEF cx_value_t*
+cx_memb(_find_it_)(const Self* self, const cx_lookup_t* keyptr, cx_iter_t* out) {
+    out->ref = NULL;
+    if (!self->root) return NULL;
+    cx_leaf_t* lf = cx_memb(_descend_)(self, keyptr, NULL, NULL);
+    const int i = cx_memb(_leaf_pos_)(lf, keyptr);
+    if (i == lf->n || cx_memb(_cmp_)(&lf->values[i], keyptr) != 0) return NULL;
+    out->_leaf = lf, out->_end = lf->values + lf->n;
+    return (out->ref = lf->values + i);
+}
+
+STC_DEF cx_iter_t
+cx_memb(_lower_bound_)(const Self* self, const cx_lookup_t* keyptr) {
+    cx_iter_t it = {NULL};
+    if (!self->root) return it;
+    cx_leaf_t* lf = cx_memb(_descend_)(self, keyptr, NULL, NULL);
+    const int i = cx_memb(_leaf_pos_)(lf, keyptr);
+    if (i == lf->n) cx_memb(_enter_)(&it, lf->next);
+    else it._leaf = lf, it.ref = lf->values + i, it._end = lf->values + lf->n;
+    return it;
+}
+
+STC_DEF cx_value_t*
+cx_memb(_back)(const Self* self) {
+    void* nd = self->root;
+    for (int h = 0; h < self->_height; ++h) nd = ((cx_inner_t *) nd)->child[((cx_inner_t *) nd)->n];
+    return ((cx_leaf_t *) nd)->values + ((cx_leaf_t *) nd)->n - 1;
+}
+
+STC_DEF cx_result_t
+cx_memb(_insert_key_)(Self* self, const cx_lookup_t* keyptr) {
+    cx_inner_t* path[_cbtmap_MAXH]; int pidx[_cbtmap_MAXH];
+    cx_result_t res = {NULL, false};
+    if (!self->root) {
+        cx_leaf_t* lf = (cx_leaf_t *) c_malloc(sizeof *lf);
+        lf->n = 0, lf->next = NULL;
+        self->root = self->_first = lf, self->_height = 0;
+    }
+    cx_leaf_t* lf = cx_memb(_descend_)(self, keyptr, path, pidx);
+    int i = cx_memb(_leaf_pos_)(lf, keyptr), m;
+    res.ref = lf->values + i;
+    if (i < lf->n && cx_memb(_cmp_)(res.ref, keyptr) == 0) return res;
+
+    memmove(res.ref + 1, res.ref, (lf->n - i)*sizeof *res.ref);
+    ++lf->n, ++self->size, res.inserted = true;
+    if (lf->n <= cx_LEAF) return res;
+
+    /* Split the leaf. The first key on the right is copied up: not the new entry, which
+       has no key yet. */
+    cx_leaf_t* rt = (cx_leaf_t *) c_malloc(sizeof *rt);
+    if ((m = lf->n/2) == i) ++m;
+    rt->n = lf->n - m, lf->n = m;
+    memcpy(rt->values, lf->values + m, rt->n*sizeof *rt->values);
+    rt->next = lf->next, lf->next = rt;
+    if (i >= m) res.ref = rt->values + (i - m);
+    cx_key_t sep = cx_memb(_key_clone_)(cx_keyref(rt->values));
+    void* child = rt;
+
+    for (int h = self->_height - 1; h >= 0; --h) {
+        cx_inner_t* in = path[h];
+        const int j = pidx[h];
+        memmove(in->keys + j + 1, in->keys + j, (in->n - j)*sizeof *in->keys);
+        memmove(in->child + j + 2, in->child + j + 1, (in->n - j)*sizeof *in->child);
+        in->keys[j] = sep, in->child[j + 1] = child;
+        if (++in->n < cx_INNER) return res;
+
+        /* Split the inner node: the middle key moves up. */
+        cx_inner_t* r = (cx_inner_t *) c_malloc(sizeof *r);
+        m = in->n/2;
+        sep = in->keys[m];
+        r->n = in->n - m - 1, in->n = m;
+        memcpy(r->keys, in->keys + m + 1, r->n*sizeof *r->keys);
+        memcpy(r->child, in->child + m + 1, (r->n + 1)*sizeof *r->child);
+        child = r;
+    }
+    cx_inner_t* root = (cx_inner_t *) c_malloc(sizeof *root);
+    root->n = 1, root->keys[0] = sep;
+    root->child[0] = self->root, root->child[1] = child;
+    self->root = root, ++self->_height;
+    assert(self->_height < _cbtmap_MAXH);
+    return res;
+}
+
+/* Remove key k and child k + 1 from in. */
+STC_INLINE void
+cx_memb(_inner_remove_)(cx_inner_t* in, int k) {
+    memmove(in->keys + k, in->keys + k + 1, (in->n - k - 1)*sizeof *in->keys);
+    memmove(in->child + k + 1, in->child + k + 2, (in->n - k - 1)*sizeof *in->child);
+    --in->n;
+}
+
+/* Restore the size bounds after an entry was removed from leaf lf, on the given path. */
+STC_DEF void
+cx_memb(_rebalance_)(Self* self, cx_leaf_t* lf, cx_inner_t** path, const int* pidx) {
+    enum { LEAFMIN = cx_LEAF/2, INNERMIN = (cx_INNER - 1)/2 };
+    if (self->_height == 0) {
+        if (lf->n == 0) { c_free(lf); self->root = self->_first = NULL; }
+        return;
+    }
+    if (lf->n >= LEAFMIN) return;
+
+    int h = self->_height - 1, j = pidx[h];
+    cx_inner_t* p = path[h];
+    cx_leaf_t *l = j > 0 ? (cx_leaf_t *) p->child[j - 1] : NULL,
+              *r = j < p->n ? (cx_leaf_t *) p->child[j + 1] : NULL;
+    if (l && l->n > LEAFMIN) { /* take the last entry of the left sibling */
+        memmove(lf->values + 1, lf->values, lf->n*sizeof *lf->values);
+        lf->values[0] = l->values[--l->n], ++lf->n;
+        i_keydel(&p->keys[j - 1]);
+        p->keys[j - 1] = cx_memb(_key_clone_)(cx_keyref(lf->values));
+        return;
+    }
+    if (r && r->n > LEAFMIN) { /* take the first entry of the right sibling */
+        lf->values[lf->n++] = r->values[0];
+        memmove(r->values, r->values + 1, --r->n*sizeof *r->values);
+        i_keydel(&p->keys[j]);
+        p->keys[j] = cx_memb(_key_clone_)(cx_keyref(r->values));
+        return;
+    }
+    if (l) r = lf, --j; /* merge r into l */
+    else l = lf;
+    memcpy(l->values + l->n, r->values, r->n*sizeof *r->values);
+    l->n += r->n, l->next = r->next;
+    c_free(r);
+    i_keydel(&p->keys[j]);
+    cx_memb(_inner_remove_)(p, j);
+
+    for (; h > 0 && p->n < INNERMIN; p = path[--h]) {
+        cx_inner_t* q = path[h - 1];
+        cx_inner_t *il, *ir;
+        j = pidx[h - 1];
+        il = j > 0 ? (cx_inner_t *) q->child[j - 1] : NULL;
+        ir = j < q->n ? (cx_inner_t *) q->child[j + 1] : NULL;
+        if (il && il->n > INNERMIN) { /* rotate right through the parent key */
+            memmove(p->keys + 1, p->keys, p->n*sizeof *p->keys);
+            memmove(p->child + 1, p->child, (p->n + 1)*sizeof *p->child);
+            p->keys[0] = q->keys[j - 1], p->child[0] = il->child[il->n];
+            q->keys[j - 1] = il->keys[il->n - 1];
+            --il->n, ++p->n;
+            return;
+        }
+        if (ir && ir->n > INNERMIN) { /* rotate left */
+            p->keys[p->n] = q->keys[j], p->child[p->n + 1] = ir->child[0];
+            q->keys[j] = ir->keys[0];
+            memmove(ir->keys, ir->keys + 1, (ir->n - 1)*sizeof *ir->keys);
+            memmove(ir->child, ir->child + 1, ir->n*sizeof *ir->child);
+            --ir->n, ++p->n;
+            return;
+        }
+        if (il) ir = p, --j; /* merge ir into il, with the parent key between */
+        else il = p;
+        il->keys[il->n] = q->keys[j];
+        memcpy(il->keys + il->n + 1, ir->keys, ir->n*sizeof *ir->keys);
+        memcpy(il->child + il->n + 1, ir->child, (ir->n + 1)*sizeof *ir->child);
+        il->n += ir->n + 1;
+        c_free(ir);
+        cx_memb(_inner_remove_)(q, j);
+    }
+    cx_inner_t* root = (cx_inner_t *) self->root;
+    if (root->n == 0) {
+        self->root = root->child[0], --self->_height;
+        c_free(root);
+    }
+}
+
+STC_DEF int
+cx_memb(_erase_)(Self* self, const cx_lookup_t* keyptr) {
+    cx_inner_t* path[_cbtmap_MAXH]; int pidx[_cbtmap_MAXH];
+    if (!self->root) return 0;
+    cx_leaf_t* lf = cx_memb(_descend_)(self, keyptr, path, pidx);
+    const int i = cx_memb(_leaf_pos_)(lf, keyptr);
+    if (i == lf->n || cx_memb(_cmp_)(&lf->values[i], keyptr) != 0) return 0;
+    cx_memb(_value_del)(&lf->values[i]);
+    memmove(lf->values + i, lf->values + i + 1, (lf->n - i - 1)*sizeof *lf->values);
+    --lf->n, --self->size;
+    cx_memb(_rebalance_)(self, lf, path, pidx);
+    return 1;
+}
+
+STC_DEF cx_iter_t
+cx_memb(_erase_at)(Self* self, cx_iter_t it) {
+    cx_leaf_t* lf = it._leaf;
+    if (lf->n > cx_LEAF/2 || (self->_height == 0 && lf->n > 1)) { /* no rebalance: erase in place */
+        cx_memb(_value_del)(it.ref);
+        memmove(it.ref, it.ref + 1, (--it._end - it.ref)*sizeof *it.ref);
+        --lf->n, --self->size;
+        if (it.ref == it._end) cx_memb(_enter_)(&it, lf->next);
+        return it;
+    }
+    cx_lookup_t key = cx_lookup_key(cx_keyref(it.ref)), nxt;
+    cx_memb(_next)(&it);
+    if (it.ref) nxt = cx_lookup_key(cx_keyref(it.ref));
+    cx_memb(_erase_)(self, &key);
+    if (it.ref) cx_memb(_find_it_)(self, &nxt, &it);
+    return it;
+}
+
+STC_DEF cx_iter_t
+cx_memb(_erase_range)(Self* self, cx_iter_t it1, cx_iter_t it2) {
+    if (!it2.ref) { while (it1.ref) it1 = cx_memb(_erase_at)(self, it1);
+                    return it1; }
+    cx_lookup_t r2 = cx_lookup_key(cx_keyref(it2.ref));
+    while (cx_memb(_cmp_)(it1.ref, &r2) < 0)
+        it1 = cx_memb(_erase_at)(self, it1);
+    return it1;
+}
+
+static void*
+cx_memb(_clone_r_)(Self* tree, const void* nd, int h, cx_leaf_t** last) {
+    if (h == 0) {
+        const cx_leaf_t* lf = (const cx_leaf_t *) nd;
+        cx_leaf_t* c = (cx_leaf_t *) c_malloc(sizeof *c);
+        c->n = lf->n, c->next = NULL;
+        for (int i = 0; i < lf->n; ++i)
+            cx_memb(_value_clone)(&c->values[i], (cx_value_t *) &lf->values[i]);
+        if (*last) (*last)->next = c; else tree->_first = c;
+        return (*last = c);
+    }
+    const cx_inner_t* in = (const cx_inner_t *) nd;
+    cx_inner_t* c = (cx_inner_t *) c_malloc(sizeof *c);
+    c->n = in->n;
+    for (int i = 0; i < in->n; ++i) c->keys[i] = cx_memb(_key_clone_)(&in->keys[i]);
+    for (int i = 0; i <= in->n; ++i) c->child[i] = cx_memb(_clone_r_)(tree, in->child[i], h - 1, last);
+    return c;
+}
+
+STC_DEF Self
+cx_memb(_clone)(Self tree) {
+    Self clone = tree;
+    cx_leaf_t* last = NULL;
+    if (tree.root) clone.root = cx_memb(_clone_r_)(&clone, tree.root, tree._height, &last);
+    return clone;
+}
+
+static void
+cx_memb(_del_r_)(void* nd, int h) {
+    if (h == 0) {
+        cx_leaf_t* lf = (cx_leaf_t *) nd;
+        for (int i = 0; i < lf->n; ++i) cx_memb(_value_del)(&lf->values[i]);
+    } else {
+        cx_inner_t* in = (cx_inner_t *) nd;
+        for (int i = 0; i < in->n; ++i) i_keydel(&in->keys[i]);
+        for (int i = 0; i <= in->n; ++i) cx_memb(_del_r_)(in->child[i], h - 1);
+    }
+    c_free(nd);
+}
+
+STC_DEF void
+cx_memb(_del)(Self* self) {
+    if (self->root) cx_memb(_del_r_)(self->root, self->_height);
+}
+
+#endif // TEMPLATED IMPLEMENTATION
+#undef cx_LEAF
+#undef cx_INNER
+#undef cx_leaf_t
+#undef cx_inner_t
+#undef cx_lookup_t
+#undef cx_lookup
+#undef cx_lookup_key
+#undef cx_keyref
+#undef cx_MAP_ONLY
+#undef cx_SET_ONLY
+#include "template.h"
+#define CBTMAP_H_INCLUDED
@@ -0,0 +1,49 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Tyge Løvset, NORCE, www.norceresearch.no
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Sorted set - implemented as a B+ tree (wide nodes, entries in linked leaves).
+/*
+#include <stdio.h>
+
+#define i_tag i
+#define i_key int
+#include <stc/cbtset.h> // sorted set of int
+
+int main(void) {
+    cbtset_i s = cbtset_i_init();
+    cbtset_i_insert(&s, 5);
+    cbtset_i_insert(&s, 8);
+    cbtset_i_insert(&s, 3);
+    cbtset_i_insert(&s, 5);
+
+    c_foreach (k, cbtset_i, s)
+        printf("set %d\n", *k.ref);
+    cbtset_i_del(&s);
+}
+*/
+
+#ifndef i_prefix
+#define i_prefix cbtset_
+#endif
+#define i_isset
+#include "cbtmap.h"
@@ -0,0 +1,267 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Tyge Løvset, NORCE, www.norceresearch.no
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Concurrent unordered map - N cmap shards, each guarded by its own spinlock.
+/*
+#include <stdio.h>
+
+#define i_tag ii
+#define i_key int
+#define i_val int
+#include <stc/ccmap.h>  // also defines cmap_ii, the shard type
+
+static void print_shard(cmap_ii* m, void* arg) {
+    c_foreach (i, cmap_ii, *m)
+        printf("map %d: %d\n", i.ref->first, i.ref->second);
+}
+
+int main(void) {
+    c_autovar (ccmap_ii m = ccmap_ii_init(), ccmap_ii_del(&m))
+    {
+        ccmap_ii_insert(&m, 5, 50);          // may be called from any thread
+        ccmap_ii_emplace_or_assign(&m, 5, 55);
+        int v;
+        if (ccmap_ii_get_copy(&m, 5, &v))
+            printf("5: %d\n", v);
+        ccmap_ii_erase(&m, 5);
+        ccmap_ii_for_each_shard(&m, print_shard, NULL);
+    }
+}
+*/
+
+#ifndef CCMAP_H_INCLUDED
+#define CCMAP_H_INCLUDED
+#include "ccommon.h"
+
+#define _ccmap_SHARDS 64 /* default number of shards */
+#define _ccmap_SPINS 64  /* pause-spins before yielding the cpu */
+
+#if defined(_MSC_VER) && !defined(__clang__)
+  #include <intrin.h>
+  #define _ccmap_xchg(p, v) _InterlockedExchange(p, v)
+  #define _ccmap_load(p) (*(volatile long *)(p))
+  #define _ccmap_release(p) ((void) _InterlockedExchange(p, 0))
+#else
+  #define _ccmap_xchg(p, v) __atomic_exchange_n(p, v, __ATOMIC_ACQUIRE)
+  #define _ccmap_load(p) __atomic_load_n(p, __ATOMIC_RELAXED)
+  #define _ccmap_release(p) __atomic_store_n(p, 0, __ATOMIC_RELEASE)
+#endif
+#if defined __SSE2__ || defined _M_X64 || defined _M_IX86
+  #include <emmintrin.h>
+  #define _ccmap_pause() _mm_pause()
+#else
+  #define _ccmap_pause() ((void) 0)
+#endif
+#if defined __unix__ || defined __APPLE__
+  #include <sched.h>
+  #define _ccmap_yield() ((void) sched_yield())
+#else
+  #define _ccmap_yield() _ccmap_pause()
+#endif
+
+/* Test-and-test-and-set: spin on a plain load, so that waiting threads do not
+   keep stealing the cache line from the owner. */
+STC_INLINE void _ccmap_lock(long* lock) {
+    while (_ccmap_xchg(lock, 1)) {
+        int n = 0;
+        while (_ccmap_load(lock))
+            if (++n < _ccmap_SPINS) _ccmap_pause();
+            else n = 0, _ccmap_yield();
+    }
+}
+STC_INLINE void _ccmap_unlock(long* lock) { _ccmap_release(lock); }
+#endif // CCMAP_H_INCLUDED
+
+#ifdef i_isset
+  #error ccmap does not support sets
+#endif
+#define i_more /* keep the template parameters after cmap.h */
+#include "cmap.h"
+#undef i_more
+#undef i_prefix
+#define i_prefix ccmap_
+#define cx_shard_t c_PASTE(cmap_, i_tag)
+#define cx_shard(name) c_PASTE(cx_shard_t, name)
+
+typedef i_key cx_key_t;
+typedef i_val cx_mapped_t;
+typedef i_keyraw cx_rawkey_t;
+typedef i_valraw cx_rawmapped_t;
+typedef cx_shard_t cx_memb(_shard_t);
+
+/* The padding keeps the locks of neighbouring shards on separate cache lines. */
+typedef struct { long lock; cx_shard_t map; char _pad[64]; } cx_memb(_slot_t);
+typedef struct { cx_memb(_slot_t)* shards; size_t nshards; } Self;
+
+STC_API Self            cx_memb(_with_shards)(size_t nshards);
+STC_API void            cx_memb(_del)(Self* self);
+STC_API void            cx_memb(_clear)(Self* self);
+STC_API void            cx_memb(_reserve)(Self* self, size_t capacity);
+STC_API size_t          cx_memb(_size)(const Self* self);
+STC_API void            cx_memb(_for_each_shard)(const Self* self,
+                                                 void (*fn)(cx_shard_t* map, void* arg), void* arg);
+
+STC_INLINE Self         cx_memb(_init)(void) { return cx_memb(_with_shards)(_ccmap_SHARDS); }
+STC_INLINE size_t       cx_memb(_shard_count)(const Self* self) { return self->nshards; }
+
+/* Shards are selected from the upper half of the 64-bit hash (cmap uses the lower
+   half), mixed with the lower half for hash functions that only produce 32 bits. */
+STC_INLINE cx_memb(_slot_t)*
+cx_memb(_slot_)(const Self* self, const cx_rawkey_t* rkeyptr) {
+    const uint64_t _hash = i_hash(rkeyptr, sizeof *rkeyptr);
+    const uint32_t _mix = ((uint32_t) (_hash >> 32) ^ (uint32_t) _hash) * 0x9e3779b9u;
+    return self->shards + fastrange_uint32_t(_mix, self->nshards);
+}
+
+STC_INLINE bool
+cx_memb(_insert)(Self* self, i_key _key, i_val _mapped) {
+    cx_rawkey_t _raw = i_keyto(&_key);
+    cx_memb(_slot_t)* _s = cx_memb(_slot_)(self, &_raw);
+    _ccmap_lock(&_s->lock);
+    bool _ins = cx_shard(_insert)(&_s->map, _key, _mapped).inserted;
+    _ccmap_unlock(&_s->lock);
+    return _ins;
+}
+
+STC_INLINE bool
+cx_memb(_emplace)(Self* self, i_keyraw rkey, i_valraw rmapped) {
+    cx_memb(_slot_t)* _s = cx_memb(_slot_)(self, &rkey);
+    _ccmap_lock(&_s->lock);
+    bool _ins = cx_shard(_emplace)(&_s->map, rkey, rmapped).inserted;
+    _ccmap_unlock(&_s->lock);
+    return _ins;
+}
+
+STC_INLINE bool
+cx_memb(_insert_or_assign)(Self* self, i_key _key, i_val _mapped) {
+    cx_rawkey_t _raw = i_keyto(&_key);
+    cx_memb(_slot_t)* _s = cx_memb(_slot_)(self, &_raw);
+    _ccmap_lock(&_s->lock);
+    bool _ins = cx_shard(_insert_or_assign)(&_s->map, _key, _mapped).inserted;
+    _ccmap_unlock(&_s->lock);
+    return _ins;
+}
+
+STC_INLINE bool
+cx_memb(_emplace_or_assign)(Self* self, i_keyraw rkey, i_valraw rmapped) {
+    cx_memb(_slot_t)* _s = cx_memb(_slot_)(self, &rkey);
+    _ccmap_lock(&_s->lock);
+    bool _ins = cx_shard(_emplace_or_assign)(&_s->map, rkey, rmapped).inserted;
+    _ccmap_unlock(&_s->lock);
+    return _ins;
+}
+
+/* Copies the mapped value into *out, as references are not safe to hand out. */
+STC_INLINE bool
+cx_memb(_get_copy)(const Self* self, i_keyraw rkey, cx_mapped_t* out) {
+    cx_memb(_slot_t)* _s = cx_memb(_slot_)(self, &rkey);
+    _ccmap_lock(&_s->lock);
+    cx_shard(_value_t)* _v = cx_shard(_get)(&_s->map, rkey);
+    if (_v) *out = i_valfrom(i_valto(&_v->second));
+    _ccmap_unlock(&_s->lock);
+    return _v != NULL;
+}
+
+STC_INLINE bool
+cx_memb(_contains)(const Self* self, i_keyraw rkey) {
+    cx_memb(_slot_t)* _s = cx_memb(_slot_)(self, &rkey);
+    _ccmap_lock(&_s->lock);
+    bool _found = cx_shard(_contains)(&_s->map, rkey);
+    _ccmap_unlock(&_s->lock);
+    return _found;
+}
+
+STC_INLINE size_t
+cx_memb(_erase)(Self* self, i_keyraw rkey) {
+    cx_memb(_slot_t)* _s = cx_memb(_slot_)(self, &rkey);
+    _ccmap_lock(&_s->lock);
+    size_t _n = cx_shard(_erase)(&_s->map, rkey);
+    _ccmap_unlock(&_s->lock);
+    return _n;
+}
+
+// -------------------------- IMPLEMENTATION -------------------------
+
+#if !defined(STC_HEADER) || defined(STC_IMPLEMENTATION) || defined(i_imp)
+
+STC_DEF Self
+cx_memb(_with_shards)(size_t nshards) {
+    Self cx = {c_new_n(cx_memb(_slot_t), nshards ? nshards : 1), nshards ? nshards : 1};
+    c_forrange (i, cx.nshards) {
+        cx.shards[i].lock = 0;
+        cx.shards[i].map = cx_shard(_init)();
+    }
+    return cx;
+}
+
+STC_DEF void
+cx_memb(_del)(Self* self) {
+    c_forrange (i, self->nshards)
+        cx_shard(_del)(&self->shards[i].map);
+    c_free(self->shards);
+}
+
+STC_DEF void
+cx_memb(_clear)(Self* self) {
+    c_forrange (i, self->nshards) {
+        _ccmap_lock(&self->shards[i].lock);
+        cx_shard(_clear)(&self->shards[i].map);
+        _ccmap_unlock(&self->shards[i].lock);
+    }
+}
+
+STC_DEF void
+cx_memb(_reserve)(Self* self, size_t capacity) {
+    size_t _per = capacity/self->nshards + (capacity % self->nshards != 0);
+    c_forrange (i, self->nshards) {
+        _ccmap_lock(&self->shards[i].lock);
+        cx_shard(_reserve)(&self->shards[i].map, _per);
+        _ccmap_unlock(&self->shards[i].lock);
+    }
+}
+
+/* Not a snapshot: shards are locked and counted one at a time. */
+STC_DEF size_t
+cx_memb(_size)(const Self* self) {
+    size_t _n = 0;
+    c_forrange (i, self->nshards) {
+        _ccmap_lock(&self->shards[i].lock);
+        _n += self->shards[i].map.size;
+        _ccmap_unlock(&self->shards[i].lock);
+    }
+    return _n;
+}
+
+STC_DEF void
+cx_memb(_for_each_shard)(const Self* self, void (*fn)(cx_shard_t* map, void* arg), void* arg) {
+    c_forrange (i, self->nshards) {
+        _ccmap_lock(&self->shards[i].lock);
+        fn(&self->shards[i].map, arg);
+        _ccmap_unlock(&self->shards[i].lock);
+    }
+}
+
+#endif // TEMPLATED IMPLEMENTATION
+#undef cx_shard_t
+#undef cx_shard
+#include "template.h"
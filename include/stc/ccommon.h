@@ -28,6 +28,7 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <string.h>
 #include <assert.h>
 
 #if defined(_MSC_VER)
@@ -39,6 +40,15 @@
 #endif
 #define STC_INLINE static inline
 
+#if defined(__GNUC__) || defined(__clang__)
+#  define c_prefetch(p) __builtin_prefetch(p)
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#  include <xmmintrin.h>
+#  define c_prefetch(p) _mm_prefetch((const char *)(p), _MM_HINT_T0)
+#else
+#  define c_prefetch(p) ((void)(p))
+#endif
+
 #if defined(STC_HEADER) || defined(STC_IMPLEMENTATION) || defined(i_imp)
 #  define STC_API extern
 #  define STC_DEF
@@ -111,7 +121,22 @@
 
 #define c_default_del(ptr)      ((void) (ptr))
 
-STC_API uint64_t c_default_hash(const void *key, size_t len);
+STC_INLINE uint64_t c_default_hash(const void *key, size_t len) {
+    const uint64_t m = 0xb5ad4eceda1ce2a9;
+    uint64_t k, h = m + len;
+    const uint8_t *p = (const uint8_t *)key, *end = p + (len & ~7ull);
+    for (; p != end; p += 8) { memcpy(&k, p, 8); h ^= m*k; }
+    switch (len & 7) {
+        case 7: h ^= (uint64_t) p[6] << 48; /* @fallthrough@ */
+        case 6: h ^= (uint64_t) p[5] << 40; /* @fallthrough@ */
+        case 5: h ^= (uint64_t) p[4] << 32; /* @fallthrough@ */
+        case 4: h ^= (uint64_t) p[3] << 24; /* @fallthrough@ */
+        case 3: h ^= (uint64_t) p[2] << 16; /* @fallthrough@ */
+        case 2: h ^= (uint64_t) p[1] << 8;  /* @fallthrough@ */
+        case 1: h ^= (uint64_t) p[0]; h *= m;
+    }
+    return h ^ (h >> 15);
+}
 #define c_default_hash32(data, len_is_4) \
     ((*(const uint32_t*)data * 0xc6a4a7935bd1e99d) >> 15)
 #define c_default_hash64(data, len_is_8) \
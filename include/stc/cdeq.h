@@ -53,6 +53,7 @@ STC_API cx_iter_t       cx_memb(_find_in)(cx_iter_t p1, cx_iter_t p2, i_valraw r
 STC_API int             cx_memb(_value_compare)(const cx_value_t* x, const cx_value_t* y);
 STC_API cx_value_t*     cx_memb(_push_front)(Self* self, i_val value);
 STC_API cx_iter_t       cx_memb(_erase_range_p)(Self* self, cx_value_t* p1, cx_value_t* p2);
+STC_API size_t          cx_memb(_retain)(Self* self, bool (*pred)(const cx_value_t*, void*), void* ctx);
 STC_API cx_iter_t       cx_memb(_insert_range_p)(Self* self, cx_value_t* pos,
                                                 const cx_value_t* p1, const cx_value_t* p2, bool clone);
 STC_API cx_iter_t       cx_memb(_emplace_range_p)(Self* self, cx_value_t* pos,
@@ -332,6 +333,19 @@ cx_memb(_emplace_range_p)(Self* self, cx_value_t* pos, const cx_rawvalue_t* p1,
     return it;
 }
 
+/* Keep the elements for which pred() is true, in order, in one pass. */
+STC_DEF size_t
+cx_memb(_retain)(Self* self, bool (*pred)(const cx_value_t*, void*), void* ctx) {
+    cx_value_t *p = self->data, *end = p + cdeq_rep_(self)->size, *q;
+    while (p != end && pred(p, ctx)) ++p;
+    for (q = p; p != end; ++p)
+        if (pred(p, ctx)) *q++ = *p;
+        else i_valdel(p);
+    size_t n = end - q;
+    if (n) cdeq_rep_(self)->size -= n;
+    return n;
+}
+
 STC_DEF cx_iter_t
 cx_memb(_erase_range_p)(Self* self, cx_value_t* p1, cx_value_t* p2) {
     size_t n = p2 - p1;
@@ -0,0 +1,131 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Tyge Løvset, NORCE, www.norceresearch.no
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef CFILEMAP_H_INCLUDED
+#define CFILEMAP_H_INCLUDED
+
+/*
+// cfilemap: map a file read-only into memory. Used by containers defined with i_persist.
+#include <stc/cfilemap.h>
+int main() {
+    size_t size;
+    const char* p = (const char *) c_file_map("data.bin", &size);
+    if (p) {
+        printf("%zu bytes, first: %d\n", size, size ? p[0] : -1);
+        c_file_unmap(p, size);
+    }
+}
+*/
+#include "ccommon.h"
+#include <stdio.h>
+
+STC_API const void*     c_file_map(const char* path, size_t* size);
+STC_API void            c_file_unmap(const void* addr, size_t size);
+STC_API bool            c_file_write(FILE* fp, const void* data, size_t size);
+STC_API bool            c_file_pad(FILE* fp, size_t size);
+
+/* -------------------------- IMPLEMENTATION ------------------------- */
+
+#if !defined(STC_HEADER) || defined(STC_IMPLEMENTATION)
+
+#if defined(_WIN32)
+  #define WIN32_LEAN_AND_MEAN
+  #include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+#else
+  #include <stdlib.h>
+#endif
+
+/* Pages are mapped read-only and private: writing to a mapped container faults. */
+STC_DEF const void*
+c_file_map(const char* path, size_t* size) {
+    void* addr = NULL;
+#if defined(_WIN32)
+    HANDLE fh = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    LARGE_INTEGER len;
+    if (fh == INVALID_HANDLE_VALUE) return NULL;
+    if (GetFileSizeEx(fh, &len) && len.QuadPart > 0) {
+        HANDLE mh = CreateFileMappingA(fh, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mh) {
+            addr = MapViewOfFile(mh, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mh);
+        }
+        *size = (size_t) len.QuadPart;
+    }
+    CloseHandle(fh);
+#elif defined(__unix__) || defined(__APPLE__)
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        addr = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) addr = NULL;
+        *size = (size_t) st.st_size;
+    }
+    close(fd);
+#else /* no mmap: read the file into memory */
+    FILE* fp = fopen(path, "rb");
+    long len;
+    if (!fp) return NULL;
+    if (fseek(fp, 0, SEEK_END) == 0 && (len = ftell(fp)) > 0 && fseek(fp, 0, SEEK_SET) == 0
+                                    && (addr = c_malloc((size_t) len))) {
+        if (fread(addr, 1, (size_t) len, fp) != (size_t) len) c_free(addr), addr = NULL;
+        *size = (size_t) len;
+    }
+    fclose(fp);
+#endif
+    return addr;
+}
+
+STC_DEF void
+c_file_unmap(const void* addr, size_t size) {
+    if (!addr) return;
+#if defined(_WIN32)
+    (void) size; UnmapViewOfFile(addr);
+#elif defined(__unix__) || defined(__APPLE__)
+    munmap((void *) addr, size);
+#else
+    (void) size; c_free((void *) addr);
+#endif
+}
+
+STC_DEF bool
+c_file_write(FILE* fp, const void* data, size_t size) {
+    return size == 0 || fwrite(data, 1, size, fp) == size;
+}
+
+STC_DEF bool
+c_file_pad(FILE* fp, size_t size) {
+    static const char zeros[64] = {0};
+    for (size_t n; size; size -= n) {
+        n = size < 64 ? size : 64;
+        if (fwrite(zeros, 1, n, fp) != n) return false;
+    }
+    return true;
+}
+
+#endif
+#endif // CFILEMAP_H_INCLUDED
@@ -0,0 +1,151 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Tyge Løvset, NORCE, www.norceresearch.no
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef CINTERN_H_INCLUDED
+#define CINTERN_H_INCLUDED
+
+// String interning: each distinct string is stored once, and gets a stable pointer and an id.
+/*
+#include <stdio.h>
+#include <stc/cintern.h>
+
+int main(void) {
+    c_auto (cintern, pool)
+    {
+        const char* a = cintern_get(&pool, "host-17");
+        const char* b = cintern_get_n(&pool, "host-17:80", 7);
+        printf("%d %u\n", a == b, cintern_id(a)); // 1 0
+    }
+}
+*/
+#include "csview.h"
+
+#define _cintern_BLOCK 65536 /* arena block size; longer strings get a block of their own */
+
+typedef struct { uint32_t id, size; } _cintern_hdr_t; /* stored just before the chars of a string */
+typedef struct _cintern_block { struct _cintern_block* next; } _cintern_block_t; /* chars follow */
+
+STC_INLINE bool _cintern_equ(const csview* x, const csview* y)
+    { return x->size == y->size && memcmp(x->str, y->str, x->size) == 0; }
+
+#define i_key csview
+#define i_hash csview_hash
+#define i_equ _cintern_equ
+#define i_cnt _cintern_set
+#include "cset.h"
+
+#define i_val const char*
+#define i_cnt _cintern_vec
+#include "cvec.h"
+
+typedef struct {
+    _cintern_set index; /* views of the interned strings, in the arena */
+    _cintern_vec strs;  /* the interned strings by id */
+    _cintern_block_t* blocks;
+    char *_pos, *_end;  /* free space in the first block */
+} cintern;
+
+STC_API const char*     cintern_get_n(cintern* self, const char* str, size_t n);
+STC_API void            cintern_del(cintern* self);
+
+STC_INLINE cintern      cintern_init(void)
+                            { cintern pool = {_cintern_set_init(), _cintern_vec_init(), NULL, NULL, NULL}; return pool; }
+STC_INLINE void         cintern_clear(cintern* self)
+                            { cintern_del(self); *self = cintern_init(); }
+STC_INLINE size_t       cintern_size(cintern pool) { return _cintern_set_size(pool.index); }
+STC_INLINE bool         cintern_empty(cintern pool) { return _cintern_set_empty(pool.index); }
+
+STC_INLINE const char*  cintern_get(cintern* self, const char* str)
+                            { return cintern_get_n(self, str, strlen(str)); }
+STC_INLINE const char*  cintern_get_v(cintern* self, csview sv)
+                            { return cintern_get_n(self, sv.str, sv.size); }
+STC_INLINE const char*  cintern_get_s(cintern* self, cstr s)
+                            { return cintern_get_n(self, s.str, cstr_size(s)); }
+
+/* The interned string equal to sv, or NULL. Does not add it. */
+STC_INLINE const char*  cintern_find_v(const cintern* self, csview sv) {
+    const csview* v = _cintern_set_get(&self->index, sv);
+    return v ? v->str : NULL;
+}
+STC_INLINE const char*  cintern_find(const cintern* self, const char* str)
+                            { return cintern_find_v(self, csview_from(str)); }
+
+/* Only for strings returned by the pool: */
+STC_INLINE uint32_t     cintern_id(const char* interned)
+                            { return ((const _cintern_hdr_t *) interned - 1)->id; }
+STC_INLINE size_t       cintern_length(const char* interned)
+                            { return ((const _cintern_hdr_t *) interned - 1)->size; }
+STC_INLINE csview       cintern_view(const char* interned)
+                            { return c_make(csview){interned, cintern_length(interned)}; }
+
+/* id must be less than cintern_size(). */
+STC_INLINE const char*  cintern_str(const cintern* self, uint32_t id)
+                            { return self->strs.data[id]; }
+
+/* -------------------------- IMPLEMENTATION ------------------------- */
+
+#if !defined(STC_HEADER) || defined(STC_IMPLEMENTATION)
+
+STC_DEF const char*
+cintern_get_n(cintern* self, const char* str, size_t n) {
+    _cintern_set_result_t res = _cintern_set_insert(&self->index, c_make(csview){str, n});
+    if (!res.inserted) return res.ref->str;
+    assert(n < UINT32_MAX && cintern_size(*self) < UINT32_MAX);
+
+    const size_t need = (sizeof(_cintern_hdr_t) + n + 1 + 3) & ~(size_t) 3;
+    char* p;
+    if ((size_t) (self->_end - self->_pos) >= need) {
+        p = self->_pos, self->_pos += need;
+    } else {
+        const bool own = need > _cintern_BLOCK/4;
+        _cintern_block_t* b = (_cintern_block_t *) c_malloc(sizeof *b + (own ? need : _cintern_BLOCK));
+        p = (char *) (b + 1);
+        if (own && self->blocks) { /* keep the free space of the first block */
+            b->next = self->blocks->next, self->blocks->next = b;
+        } else {
+            b->next = self->blocks, self->blocks = b;
+            self->_pos = p + need, self->_end = p + (own ? need : _cintern_BLOCK);
+        }
+    }
+    _cintern_hdr_t* h = (_cintern_hdr_t *) p;
+    h->id = (uint32_t) _cintern_vec_size(self->strs);
+    h->size = (uint32_t) n;
+    char* s = (char *) (h + 1);
+    memcpy(s, str, n); s[n] = '\0';
+    res.ref->str = s; /* the same chars: the hash is unchanged */
+    _cintern_vec_push_back(&self->strs, s);
+    return s;
+}
+
+STC_DEF void
+cintern_del(cintern* self) {
+    _cintern_set_del(&self->index);
+    _cintern_vec_del(&self->strs);
+    while (self->blocks) {
+        _cintern_block_t* b = self->blocks;
+        self->blocks = b->next;
+        c_free(b);
+    }
+}
+
+#endif
+#endif
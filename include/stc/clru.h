@@ -0,0 +1,325 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Tyge Løvset, NORCE, www.norceresearch.no
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// LRU cache: a cmap index over pooled nodes, on a recency list. With i_clock, a CLOCK (second chance) cache.
+/*
+#include <stdio.h>
+
+#define i_tag ii
+#define i_key int
+#define i_val int
+#include <stc/clru.h>  // also defines clru_index_ii, a cmap from the keys to nodes
+
+static void on_evict(int key, int* val, void* ctx) { printf("evict %d: %d\n", key, *val); }
+
+int main(void) {
+    c_autovar (clru_ii c = clru_ii_with_capacity(2), clru_ii_del(&c))
+    {
+        clru_ii_set_on_evict(&c, on_evict, NULL);
+        clru_ii_put(&c, 1, 10);
+        clru_ii_put(&c, 2, 20);
+        clru_ii_get(&c, 1);         // 1 is now the most recently used
+        clru_ii_put(&c, 3, 30);     // evict 2: 20
+        printf("%d %d\n", clru_ii_contains(&c, 1), clru_ii_contains(&c, 2));
+    }
+}
+*/
+#ifndef CLRU_H_INCLUDED
+#define CLRU_H_INCLUDED
+#include "ccommon.h"
+#include <stdlib.h>
+#include <string.h>
+#endif // CLRU_H_INCLUDED
+
+#ifdef i_isset
+  #error clru does not support sets
+#endif
+#define i_prefix clru_
+#include "template.h"
+#ifdef i_cost
+  #define cx_COST_ONLY c_true
+  #define cx_cost(d) (d)->_cost
+#else
+  #define cx_COST_ONLY c_false
+  #define cx_cost(d) 1
+#endif
+#ifdef i_clock
+  #define cx_CLOCK_ONLY c_true
+  #define cx_LRU_ONLY c_false
+#else
+  #define cx_CLOCK_ONLY c_false
+  #define cx_LRU_ONLY c_true
+#endif
+typedef i_key cx_key_t;
+typedef i_val cx_mapped_t;
+typedef i_keyraw cx_rawkey_t;
+typedef i_valraw cx_rawmapped_t;
+
+/* The mapped type is handled here, as the index below is a cmap with node numbers as values. */
+STC_INLINE void cx_memb(_mapped_del_)(cx_mapped_t* _val) { i_valdel(_val); }
+STC_INLINE cx_mapped_t cx_memb(_mapped_from_)(cx_rawmapped_t _raw) { return i_valfrom(_raw); }
+
+#undef i_val
+#undef i_val_str
+#undef i_val_csptr
+#undef i_valdel
+#undef i_valfrom
+#undef i_valto
+#undef i_valraw
+#undef i_template
+#undef i_prefix
+#define i_prefix clru_index_
+#define i_val uint32_t
+#define i_more /* keep the template parameters after cmap.h */
+#include "cmap.h"
+#undef i_more
+#undef i_prefix
+#define i_prefix clru_
+#define cx_index_t c_PASTE(clru_index_, i_tag)
+#define cx_index(name) c_PASTE(cx_index_t, name)
+
+/* Node 0 is the head of the recency list, the free list is linked through _next. A node keeps
+   the raw key of its index entry for eviction: cmap entries move, but a raw key (a plain
+   key, or the chars of a cstr) stays valid while the entry exists. */
+typedef struct {
+    cx_mapped_t value;
+    cx_rawkey_t _rkey;
+    uint32_t _prev, _next;
+    cx_COST_ONLY( size_t _cost; )
+    cx_CLOCK_ONLY( uint8_t _ref; ) /* with i_clock: 1 if used since the hand passed, 2 if free, 3 if pinned */
+} cx_memb(_node_t);
+
+typedef struct {
+    cx_index_t index;
+    cx_memb(_node_t)* nodes;
+    uint32_t _nodes, _capnodes, _free; /* nodes in use or free, allocated, and first free */
+    cx_CLOCK_ONLY( uint32_t _hand; )
+    size_t cost, capacity; /* with i_cost the sum of entry costs, else the number of entries */
+    void (*_on_evict)(cx_rawkey_t key, cx_mapped_t* val, void* ctx);
+    void* _ctx;
+} Self;
+
+typedef cx_index_t cx_memb(_index_t);
+
+STC_API Self            cx_memb(_with_capacity)(size_t capacity);
+STC_API void            cx_memb(_del)(Self* self);
+STC_API void            cx_memb(_clear)(Self* self);
+STC_API void            cx_memb(_set_capacity)(Self* self, size_t capacity);
+STC_API cx_mapped_t*    cx_memb(_put)(Self* self, i_key key, cx_mapped_t mapped);
+STC_API size_t          cx_memb(_erase)(Self* self, i_keyraw rkey);
+STC_API void            cx_memb(_evict_)(Self* self);
+
+STC_INLINE Self         cx_memb(_init)(void) { return cx_memb(_with_capacity)((size_t) -1); }
+STC_INLINE size_t       cx_memb(_size)(Self c) { return cx_index(_size)(c.index); }
+STC_INLINE bool         cx_memb(_empty)(Self c) { return cx_index(_size)(c.index) == 0; }
+STC_INLINE size_t       cx_memb(_cost)(Self c) { return c.cost; }
+STC_INLINE size_t       cx_memb(_capacity)(Self c) { return c.capacity; }
+
+/* fn is called with each evicted entry, before its key and value are destroyed. */
+STC_INLINE void
+cx_memb(_set_on_evict)(Self* self, void (*fn)(cx_rawkey_t key, cx_mapped_t* val, void* ctx), void* ctx)
+    { self->_on_evict = fn, self->_ctx = ctx; }
+
+#ifndef i_clock
+STC_INLINE void
+cx_memb(_unlink_)(Self* self, uint32_t n) {
+    cx_memb(_node_t)* _d = self->nodes;
+    _d[_d[n]._prev]._next = _d[n]._next;
+    _d[_d[n]._next]._prev = _d[n]._prev;
+}
+
+STC_INLINE void
+cx_memb(_push_front_)(Self* self, uint32_t n) {
+    cx_memb(_node_t)* _d = self->nodes;
+    _d[n]._prev = 0, _d[n]._next = _d[0]._next;
+    _d[_d[0]._next]._prev = n, _d[0]._next = n;
+}
+#endif
+
+/* Mark node n as used: move it to the front of the list, or with i_clock only set its bit. */
+STC_INLINE void
+cx_memb(_touch_)(Self* self, uint32_t n) {
+#ifdef i_clock
+    if (!self->nodes[n]._ref) self->nodes[n]._ref = 1;
+#else
+    if (self->nodes[0]._next != n)
+        cx_memb(_unlink_)(self, n), cx_memb(_push_front_)(self, n);
+#endif
+}
+
+/* The value of rkey, marked as used, or NULL. Valid until the next put(). */
+STC_INLINE cx_mapped_t*
+cx_memb(_get)(Self* self, i_keyraw rkey) {
+    cx_index(_value_t)* _v = cx_index(_get)(&self->index, rkey);
+    if (!_v) return NULL;
+    cx_memb(_touch_)(self, _v->second);
+    return &self->nodes[_v->second].value;
+}
+
+/* The value of rkey without marking it as used, or NULL. */
+STC_INLINE const cx_mapped_t*
+cx_memb(_peek)(const Self* self, i_keyraw rkey) {
+    cx_index(_value_t)* _v = cx_index(_get)(&self->index, rkey);
+    return _v ? &self->nodes[_v->second].value : NULL;
+}
+
+STC_INLINE bool
+cx_memb(_contains)(const Self* self, i_keyraw rkey)
+    { return cx_index(_contains)(&self->index, rkey); }
+
+STC_INLINE cx_mapped_t*
+cx_memb(_emplace)(Self* self, i_keyraw rkey, cx_rawmapped_t rmapped) {
+    cx_index(_value_t)* _v = cx_index(_get)(&self->index, rkey);
+    if (!_v) return cx_memb(_put)(self, i_keyfrom(rkey), cx_memb(_mapped_from_)(rmapped));
+    cx_memb(_touch_)(self, _v->second);
+    return &self->nodes[_v->second].value;
+}
+
+/* -------------------------- IMPLEMENTATION ------------------------- */
+
+#if !defined(STC_HEADER) || defined(STC_IMPLEMENTATION) || defined(i_imp)
+
+STC_DEF Self
+cx_memb(_with_capacity)(size_t capacity) {
+    Self c = {cx_index(_init)(), NULL, 1, 0, 0};
+    c.capacity = capacity;
+    return c;
+}
+
+STC_DEF void
+cx_memb(_clear)(Self* self) {
+    c_foreach (i, cx_index_t, self->index)
+        cx_memb(_mapped_del_)(&self->nodes[i.ref->second].value);
+    if (self->nodes) self->nodes[0]._prev = self->nodes[0]._next = 0;
+    cx_index(_clear)(&self->index);
+    self->_nodes = 1, self->_free = 0, self->cost = 0;
+    cx_CLOCK_ONLY( self->_hand = 0; )
+}
+
+STC_DEF void
+cx_memb(_del)(Self* self) {
+    cx_memb(_clear)(self);
+    cx_index(_del)(&self->index);
+    c_free(self->nodes);
+}
+
+/* Remove node n and its index entry. */
+STC_INLINE void
+cx_memb(_drop_)(Self* self, uint32_t n) {
+    cx_memb(_node_t)* _d = self->nodes + n;
+    cx_LRU_ONLY( cx_memb(_unlink_)(self, n); )
+    cx_CLOCK_ONLY( _d->_ref = 2; )
+    self->cost -= cx_cost(_d);
+    cx_index(_erase)(&self->index, _d->_rkey);
+    cx_memb(_mapped_del_)(&_d->value);
+    _d->_next = self->_free, self->_free = n;
+}
+
+/* Evict the least recently used entry. With i_clock: the first entry at or after the hand that
+   is not marked as used; marks are cleared as the hand passes. */
+STC_DEF void
+cx_memb(_evict_)(Self* self) {
+#ifdef i_clock
+    uint32_t n = self->_hand;
+    for (;;) {
+        if (++n == self->_nodes) n = 1;
+        if (self->nodes[n]._ref == 0) break;
+        if (self->nodes[n]._ref == 1) self->nodes[n]._ref = 0; /* second chance */
+    }
+    self->_hand = n;
+#else
+    uint32_t n = self->nodes[0]._prev;
+#endif
+    if (self->_on_evict)
+        self->_on_evict(self->nodes[n]._rkey, &self->nodes[n].value, self->_ctx);
+    cx_memb(_drop_)(self, n);
+}
+
+STC_DEF void
+cx_memb(_set_capacity)(Self* self, size_t capacity) {
+    self->capacity = capacity;
+    while (self->cost > capacity && cx_index(_size)(self->index))
+        cx_memb(_evict_)(self);
+}
+
+/* Insert or assign key, mark it as used, and evict entries while over capacity. The new entry
+   itself is kept, even if its cost alone exceeds the capacity. */
+STC_DEF cx_mapped_t*
+cx_memb(_put)(Self* self, i_key _key, cx_mapped_t _mapped) {
+    cx_index(_result_t) _res = cx_index(_insert)(&self->index, _key, 0);
+    uint32_t n = _res.ref->second;
+    cx_memb(_node_t)* _d;
+    if (_res.inserted) {
+        if (self->_free) n = self->_free, self->_free = self->nodes[n]._next;
+        else {
+            if (self->_nodes >= self->_capnodes) {
+                self->_capnodes = self->_capnodes ? self->_capnodes*2 : 8;
+                self->nodes = (cx_memb(_node_t) *) c_realloc(self->nodes, self->_capnodes*sizeof *self->nodes);
+                if (self->_nodes == 1) self->nodes[0]._prev = self->nodes[0]._next = 0;
+            }
+            n = self->_nodes++;
+        }
+        _res.ref->second = n;
+        _d = self->nodes + n;
+        _d->_rkey = i_keyto(&_res.ref->first);
+        cx_LRU_ONLY( cx_memb(_push_front_)(self, n); )
+        cx_CLOCK_ONLY( _d->_ref = 0; )
+    } else {
+        _d = self->nodes + n;
+        self->cost -= cx_cost(_d);
+        cx_memb(_mapped_del_)(&_d->value);
+        cx_memb(_touch_)(self, n);
+    }
+    _d->value = _mapped;
+#ifdef i_cost
+    _d->_cost = i_cost(&_d->_rkey, &_d->value);
+    self->cost += _d->_cost;
+#else
+    self->cost += 1;
+#endif
+#ifdef i_clock
+    uint8_t _ref = _d->_ref;
+    _d->_ref = 3; /* not evicted by the hand */
+#endif
+    while (self->cost > self->capacity && cx_index(_size)(self->index) > 1)
+        cx_memb(_evict_)(self);
+    cx_CLOCK_ONLY( self->nodes[n]._ref = _ref; )
+    return &self->nodes[n].value;
+}
+
+STC_DEF size_t
+cx_memb(_erase)(Self* self, i_keyraw rkey) {
+    cx_index(_value_t)* _v = cx_index(_get)(&self->index, rkey);
+    if (!_v) return 0;
+    cx_memb(_drop_)(self, _v->second);
+    return 1;
+}
+
+#endif // TEMPLATED IMPLEMENTATION
+#undef cx_index_t
+#undef cx_index
+#undef cx_COST_ONLY
+#undef cx_cost
+#undef cx_CLOCK_ONLY
+#undef cx_LRU_ONLY
+#include "template.h"
@@ -54,31 +54,256 @@ int main(void) {
 #include <stdlib.h>
 #include <string.h>
 
-#define _cmap_inits {NULL, NULL, 0, 0, 0.85f}
-typedef struct      { size_t idx; uint_fast8_t hx; } chash_bucket_t;
+#define _cmap_inits {.table = NULL, ._hashx = NULL, .size = 0, .bucket_count = 0, .max_load_factor = 0.85f}
+#define _cmap_BATCH 16 /* lookups in flight in get_n()/contains_n() */
+#define _cmap_MIGRATE 32 /* min. buckets moved per insert/erase with i_incremental */
+/* i_stats counters are added once per lookup, with relaxed atomics where available,
+   so that concurrent readers of a map do not race on them. */
+#if defined __GNUC__ || defined __clang__
+  #define _cmap_stat_add(p, n) ((void) __atomic_fetch_add(p, n, __ATOMIC_RELAXED))
+  #define _cmap_stat_load(p) __atomic_load_n(p, __ATOMIC_RELAXED)
+#else
+  #define _cmap_stat_add(p, n) ((void) (*(p) += (n)))
+  #define _cmap_stat_load(p) (*(p))
+#endif
+typedef struct      { size_t idx; uint_fast8_t hx; uint64_t hash; } chash_bucket_t;
+#define fastrange_uint32_t(x, n) ((size_t) (((uint32_t)(x)*(uint64_t)(n)) >> 32))
+#ifdef c_umul128
+STC_INLINE size_t fastrange_uint64_t(uint64_t x, uint64_t n)
+    { uint64_t lo, hi; c_umul128(x, n, &lo, &hi); return (size_t) hi; }
+#endif
+/* Home bucket of a hash, selected by i_size: uint32_t uses the low half of the hash,
+   uint64_t all of it, spread to the high bits so that weak hashes still reach every bucket. */
+#define _cmap_bucket_uint32_t(h, n) fastrange_uint32_t(h, n)
+#define _cmap_bucket_uint64_t(h, n) fastrange_uint64_t((h)*0x9e3779b97f4a7c15, n)
+
+/* A table is one allocation: the metadata bytes, with i_storehash the hashes, then
+   the slots, each part starting on a cache line. */
+#define _cmap_ALIGN(n) (((n) + 63) & ~(size_t) 63)
+STC_INLINE void* _cmap_alloc(size_t size, size_t zeroed)
+    { void* p = c_malloc(size); memset(p, 0, zeroed); return p; }
+STC_INLINE void _cmap_free(void* p, size_t size) { (void) size; c_free(p); }
+STC_INLINE void _cmap_zero(void* p, size_t n, size_t size) { (void) size; memset(p, 0, n); }
+
+#define _cmap_PROBE_BINS 16
+/* Result of cmap_X_stats(). The probe length of an entry is the number of buckets
+   a successful lookup visits, 1 when it sits in its home bucket. */
+typedef struct {
+    size_t size, bucket_count, bytes; /* bytes allocated for table, _hashx (and _hashv) */
+    double avg_probe_length;
+    size_t max_probe_length;
+    size_t probe_histogram[_cmap_PROBE_BINS]; /* [i]: entries with length i+1, last: longer */
+    size_t clusters, max_cluster; /* runs of occupied buckets */
+    size_t rehashes, probes, equal_calls; /* counted with i_stats, else 0 */
+} chash_stats_t;
 #endif // CMAP_H_INCLUDED
 
+#if defined i_simd && !defined CMAP_SIMD_INCLUDED && \
+    (defined __SSE2__ || defined _M_X64 || defined _M_IX86_FP && _M_IX86_FP >= 2)
+#define CMAP_SIMD_INCLUDED
+/* Group probing: scan _cmap_GROUP metadata bytes at once, yielding bitmasks for
+   fingerprint matches and empty buckets. */
+#if defined __AVX2__
+  #include <immintrin.h>
+  #define _cmap_GROUP 32
+  STC_INLINE uint32_t _cmap_group_(const uint8_t* hx, uint8_t v, uint32_t* empty) {
+      __m256i g = _mm256_loadu_si256((const __m256i *) hx);
+      *empty = (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(g, _mm256_setzero_si256()));
+      return (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(g, _mm256_set1_epi8((char) v)));
+  }
+#else
+  #include <emmintrin.h>
+  #define _cmap_GROUP 16
+  STC_INLINE uint32_t _cmap_group_(const uint8_t* hx, uint8_t v, uint32_t* empty) {
+      __m128i g = _mm_loadu_si128((const __m128i *) hx);
+      *empty = (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_setzero_si128()));
+      return (uint32_t) _mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8((char) v)));
+  }
+#endif
+#if defined(__GNUC__) || defined(__clang__)
+  #define _cmap_ctz(m) __builtin_ctz(m)
+#elif defined(_MSC_VER)
+  #include <intrin.h>
+  STC_INLINE int _cmap_ctz(uint32_t m) { unsigned long i; _BitScanForward(&i, m); return (int) i; }
+#endif
+#endif // CMAP_SIMD_INCLUDED
+
+#if defined i_hugepages && !defined CMAP_HUGEPAGES_INCLUDED && (defined __unix__ || defined __APPLE__)
+#define CMAP_HUGEPAGES_INCLUDED
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+#if defined CMAP_HUGEPAGES_INCLUDED && !defined CMAP_HUGEPAGES_MMAP && defined MAP_ANONYMOUS && defined MADV_DONTNEED
+#define CMAP_HUGEPAGES_MMAP /* not available e.g. in strict ISO C mode: tables are malloc'ed */
+/* Tables of _cmap_HUGEPAGE bytes or more are mapped directly from the OS, aligned to
+   and advised for transparent huge pages. Fresh pages are zero, so nothing is cleared. */
+#define _cmap_HUGEPAGE ((size_t) 1 << 21)
+STC_INLINE void* _cmap_hp_alloc(size_t size, size_t zeroed) {
+    if (size < _cmap_HUGEPAGE) return _cmap_alloc(size, zeroed);
+    size = (size + _cmap_HUGEPAGE - 1) & ~(_cmap_HUGEPAGE - 1);
+    char* p = (char *) mmap(NULL, size + _cmap_HUGEPAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == (char *) MAP_FAILED) return NULL;
+    char* a = (char *) (((uintptr_t) p + _cmap_HUGEPAGE - 1) & ~(uintptr_t) (_cmap_HUGEPAGE - 1));
+    if (a != p) munmap(p, a - p);
+    if (a != p + _cmap_HUGEPAGE) munmap(a + size, p + _cmap_HUGEPAGE - a);
+#ifdef MADV_HUGEPAGE
+    madvise(a, size, MADV_HUGEPAGE);
+#endif
+    return a;
+}
+STC_INLINE void _cmap_hp_free(void* p, size_t size) {
+    if (size < _cmap_HUGEPAGE) c_free(p);
+    else if (p) munmap(p, (size + _cmap_HUGEPAGE - 1) & ~(_cmap_HUGEPAGE - 1));
+}
+/* Give whole pages back to be re-zeroed lazily, instead of writing them. */
+STC_INLINE void _cmap_hp_zero(void* p, size_t n, size_t size) {
+    size_t pages = 0;
+    if (size >= _cmap_HUGEPAGE) {
+        pages = n & ~((size_t) sysconf(_SC_PAGESIZE) - 1);
+        if (pages && madvise(p, pages, MADV_DONTNEED) != 0) pages = 0;
+    }
+    memset((char *) p + pages, 0, n - pages);
+}
+#endif // CMAP_HUGEPAGES_MMAP
+
+#if defined i_inline && !defined CMAP_INLINE_INCLUDED
+#define CMAP_INLINE_INCLUDED
+/* Metadata seen by iterators over inline entries: every slot is occupied. */
+#define _cmap_1x8 1, 1, 1, 1, 1, 1, 1, 1
+static const uint8_t _cmap_inl_hx[65] = {_cmap_1x8, _cmap_1x8, _cmap_1x8, _cmap_1x8,
+                                         _cmap_1x8, _cmap_1x8, _cmap_1x8, _cmap_1x8, 1};
+#undef _cmap_1x8
+#endif // CMAP_INLINE_INCLUDED
+
+#if defined i_persist && !defined CMAP_PERSIST_INCLUDED
+#define CMAP_PERSIST_INCLUDED
+#include "cfilemap.h"
+/* Header of a saved map image. The arrays follow: table, _hashx, and with
+   i_storehash an aligned _hashv. */
+typedef struct {
+    char magic[8];
+    uint64_t file_size, bucket_count, size;
+    uint32_t value_size, hxsize, flags;
+    float max_load_factor;
+    char _pad[16];
+} _cmap_image_t;
+#endif // CMAP_PERSIST_INCLUDED
+
 #ifndef i_prefix
 #define i_prefix cmap_
 #endif
 #ifdef i_isset
   #define cx_MAP_ONLY c_false
   #define cx_SET_ONLY c_true
+  #define cx_PAIR_ONLY c_false
+  #define cx_keyref(vp) (vp)
+#elif defined i_soa
+  #define cx_MAP_ONLY c_true
+  #define cx_SET_ONLY c_false
+  #define cx_PAIR_ONLY c_false
   #define cx_keyref(vp) (vp)
 #else
   #define cx_MAP_ONLY c_true
   #define cx_SET_ONLY c_false
+  #define cx_PAIR_ONLY c_true
   #define cx_keyref(vp) (&(vp)->first)
 #endif
 #include "template.h"
-#ifndef i_fwd
-cx_deftypes(_c_chash_types, Self, i_key, i_val, cx_MAP_ONLY, cx_SET_ONLY);
+#ifdef i_key_str
+  #include "csview.h"
+#endif
+#if defined i_simd && defined CMAP_SIMD_INCLUDED
+  #define cx_hxsize(cap) ((cap) + _cmap_GROUP) /* loads may overrun the sentinel */
+#else
+  #define cx_hxsize(cap) ((cap) + 1)
+#endif
+#ifdef i_incremental
+  #define cx_INCR_ONLY c_true
+  #ifdef i_fwd
+    #error i_incremental is not supported with forward declared maps (i_fwd)
+  #endif
+#else
+  #define cx_INCR_ONLY c_false
+#endif
+#ifdef i_storehash
+  #define cx_HASH_ONLY c_true
+  #ifdef i_fwd
+    #error i_storehash is not supported with forward declared maps (i_fwd)
+  #endif
+#else
+  #define cx_HASH_ONLY c_false
+#endif
+#ifdef i_robinhood
+  #if defined i_simd
+    #error i_robinhood and i_simd cannot be combined
+  #endif
+  /* The metadata byte holds the displacement from the home bucket + 1, saturated at 255. */
+  #define cx_rh_hx(d) ((uint8_t) ((d) < 254 ? (d) + 1 : 255))
+  #define cx_found(self, b) ((b).hx != 0)
+#else
+  #define cx_found(self, b) ((self)->_hashx[(b).idx] != 0)
+#endif
+#if defined i_hugepages && defined CMAP_HUGEPAGES_MMAP
+  #define cx_alloc _cmap_hp_alloc
+  #define cx_free _cmap_hp_free
+  #define cx_zero _cmap_hp_zero
+#else
+  #define cx_alloc _cmap_alloc
+  #define cx_free _cmap_free
+  #define cx_zero _cmap_zero
+#endif
+#ifdef i_stats
+  #define cx_STAT_ONLY c_true
+  #ifdef i_fwd
+    #error i_stats is not supported with forward declared maps (i_fwd)
+  #endif
+#else
+  #define cx_STAT_ONLY c_false
+#endif
+#ifdef i_inline
+  #define cx_INL_ONLY c_true
+  #if defined i_fwd || defined i_incremental || defined i_persist
+    #error i_inline cannot be combined with i_fwd, i_incremental or i_persist
+  #elif i_inline < 1 || i_inline > 64
+    #error i_inline must be in 1..64
+  #endif
+  /* bucket_count is 0 while the entries are kept inline. */
+  #define cx_inl(self) ((self)->bucket_count == 0)
+  enum { cx_memb(_INLINE) = i_inline };
+#else
+  #define cx_INL_ONLY c_false
+#endif
+#ifdef i_soa
+  #define cx_SOA_ONLY c_true
+  #if defined i_isset || defined i_fwd || defined i_incremental || defined i_inline || defined i_persist
+    #error i_soa is for maps, and cannot be combined with i_fwd, i_incremental, i_inline or i_persist
+  #endif
+  /* The table holds only the keys: a value_t is the key, and its mapped value
+     is at the same index in _vals. */
+  #define cx_mapped(self, vp) ((self)->_vals + ((vp) - (self)->table))
+#else
+  #define cx_SOA_ONLY c_false
+  #define cx_mapped(self, vp) (&(vp)->second)
+#endif
+#if defined i_multi && (defined i_incremental || defined i_inline || defined i_robinhood)
+  #error i_multi cannot be combined with i_incremental, i_inline or i_robinhood
+#endif
+#ifndef i_size
+  #define i_size MAP_SIZE_T
 #endif
+#define cx_bucket(hash, n) c_PASTE(_cmap_bucket_, i_size)(hash, n)
 
-cx_MAP_ONLY( struct cx_value_t {
-    cx_key_t first;
-    cx_mapped_t second;
+cx_PAIR_ONLY( struct cx_value_t { /* complete before the map, which may hold entries inline */
+    i_key first;
+    i_val second;
 }; )
+#if defined i_soa /* value_t is the key */
+cx_deftypes(_c_chash_types, Self, i_key, i_val, i_size, c_false, c_true, cx_INCR_ONLY,
+                                  cx_HASH_ONLY, cx_STAT_ONLY, cx_INL_ONLY, cx_SOA_ONLY);
+#elif !defined i_fwd
+cx_deftypes(_c_chash_types, Self, i_key, i_val, i_size, cx_MAP_ONLY, cx_SET_ONLY, cx_INCR_ONLY,
+                                  cx_HASH_ONLY, cx_STAT_ONLY, cx_INL_ONLY, cx_SOA_ONLY);
+#endif
 
 typedef i_keyraw cx_rawkey_t;
 typedef i_valraw cx_memb(_rawmapped_t);
@@ -87,14 +312,47 @@ typedef cx_SET_ONLY( i_keyraw )
                               i_valraw second; } )
 cx_rawvalue_t;
 
+/* Keys are looked up through cx_lookup_t. String keys use csview: hashed with
+   a known length, and compared with memcmp. */
+#ifdef i_key_str
+  #define cx_lookup_t csview
+  #define cx_lookup(rkey) csview_from(rkey)
+  #define cx_lookup_key(keyp) cstr_to_v(keyp)
+#else
+  #define cx_lookup_t cx_rawkey_t
+  #define cx_lookup(rkey) (rkey)
+  #define cx_lookup_key(keyp) i_keyto(keyp)
+#endif
+
 STC_API Self            cx_memb(_with_capacity)(size_t cap);
 STC_API Self            cx_memb(_clone)(Self map);
 STC_API void            cx_memb(_del)(Self* self);
 STC_API void            cx_memb(_clear)(Self* self);
 STC_API void            cx_memb(_reserve)(Self* self, size_t capacity);
-STC_API chash_bucket_t  cx_memb(_bucket_)(const Self* self, const cx_rawkey_t* rkeyptr);
-STC_API cx_result_t     cx_memb(_insert_entry_)(Self* self, i_keyraw rkey);
+STC_API chash_bucket_t  cx_memb(_bucket_)(const Self* self, const cx_lookup_t* keyptr);
+STC_API chash_bucket_t  cx_memb(_probe_)(const Self* self, const cx_lookup_t* keyptr, chash_bucket_t b);
+STC_API size_t          cx_memb(_get_n)(const Self* self, const cx_rawkey_t keys[], size_t n, cx_value_t* out[]);
+STC_API size_t          cx_memb(_contains_n)(const Self* self, const cx_rawkey_t keys[], size_t n, bool out[]);
+STC_API cx_result_t     cx_memb(_insert_key_)(Self* self, const cx_lookup_t* keyptr);
 STC_API void            cx_memb(_erase_entry)(Self* self, cx_value_t* val);
+STC_API size_t          cx_memb(_retain)(Self* self, bool (*pred)(const cx_value_t*, void*), void* ctx);
+STC_API chash_stats_t   cx_memb(_stats)(const Self* self);
+cx_INCR_ONLY(
+STC_API cx_value_t*     cx_memb(_find_old_)(const Self* self, const cx_lookup_t* keyptr);
+STC_API void            cx_memb(_migrate_)(Self* self, size_t n);
+)
+#ifdef i_persist
+STC_API bool            cx_memb(_save)(const Self* self, FILE* fp);
+STC_API Self            cx_memb(_map_file)(const char* path);
+STC_API void            cx_memb(_unmap)(Self* self);
+
+/* The arrays of a mapped image follow the table, those of an allocated map precede it. */
+STC_INLINE bool         cx_memb(_is_mapped)(const Self* self)
+                            { return self->_hashx && (uintptr_t) self->table <= (uintptr_t) self->_hashx; }
+  #define cx_writable_(self) assert(!cx_memb(_is_mapped)(self) && "map from map_file() is read-only")
+#else
+  #define cx_writable_(self) ((void)0)
+#endif
 
 STC_INLINE Self         cx_memb(_init)(void) { return c_make(Self)_cmap_inits; }
 STC_INLINE void         cx_memb(_shrink_to_fit)(Self* self) { cx_memb(_reserve)(self, self->size); }
@@ -102,12 +360,16 @@ STC_INLINE void         cx_memb(_max_load_factor)(Self* self, float ml) {self->m
 STC_INLINE bool         cx_memb(_empty)(Self m) { return m.size == 0; }
 STC_INLINE size_t       cx_memb(_size)(Self m) { return m.size; }
 STC_INLINE size_t       cx_memb(_bucket_count)(Self map) { return map.bucket_count; }
+#ifdef i_inline
+STC_INLINE size_t       cx_memb(_capacity)(Self map)
+                            { return cx_inl(&map) ? i_inline : (size_t) (map.bucket_count * map.max_load_factor); }
+#else
 STC_INLINE size_t       cx_memb(_capacity)(Self map)
                             { return (size_t) (map.bucket_count * map.max_load_factor); }
+#endif
 STC_INLINE void         cx_memb(_swap)(Self *map1, Self *map2) {c_swap(Self, *map1, *map2); }
-STC_INLINE bool         cx_memb(_contains)(const Self* self, i_keyraw rkey)
-                            { return self->size && self->_hashx[cx_memb(_bucket_)(self, &rkey).idx]; }
 
+#ifndef i_multi
 cx_MAP_ONLY(
     STC_API cx_result_t cx_memb(_insert_or_assign)(Self* self, i_key _key, i_val _mapped);
     STC_API cx_result_t cx_memb(_emplace_or_assign)(Self* self, i_keyraw rkey, i_valraw rmapped);
@@ -117,29 +379,60 @@ cx_MAP_ONLY(
         return cx_memb(_insert_or_assign)(self, key, mapped);
     }
 
-    STC_INLINE cx_mapped_t*
-    cx_memb(_at)(const Self* self, i_keyraw rkey) {
-        chash_bucket_t b = cx_memb(_bucket_)(self, &rkey);
-        return &self->table[b.idx].second;
-    }
 )
+#endif
 
 STC_INLINE void
 cx_memb(_value_clone)(cx_value_t* _dst, cx_value_t* _val) {
     *cx_keyref(_dst) = i_keyfrom(i_keyto(cx_keyref(_val)));
-    cx_MAP_ONLY( _dst->second = i_valfrom(i_valto(&_val->second)); )
+    cx_PAIR_ONLY( _dst->second = i_valfrom(i_valto(&_val->second)); )
 }
 
+#ifndef i_soa
 STC_INLINE cx_rawvalue_t
 cx_memb(_value_toraw)(cx_value_t* val) {
     return cx_SET_ONLY( i_keyto(val) )
            cx_MAP_ONLY( c_make(cx_rawvalue_t){i_keyto(&val->first), i_valto(&val->second)} );
 }
+#endif
 
 STC_INLINE void
 cx_memb(_value_del)(cx_value_t* _val) {
     i_keydel(cx_keyref(_val));
-    cx_MAP_ONLY( i_valdel(&_val->second); )
+    cx_PAIR_ONLY( i_valdel(&_val->second); )
+}
+
+/* Destroy the entry at e, with i_soa also its mapped value. */
+STC_INLINE void
+cx_memb(_entry_del_)(const Self* self, cx_value_t* e) {
+    cx_memb(_value_del)(e);
+    cx_SOA_ONLY( i_valdel(cx_mapped(self, e)); )
+}
+
+STC_INLINE bool
+cx_memb(_equ_)(cx_value_t* val, const cx_lookup_t* keyptr) {
+#ifdef i_key_str
+    return cstr_equals_v(*cx_keyref(val), *keyptr);
+#else
+    cx_rawkey_t _raw = i_keyto(cx_keyref(val));
+    return i_equ(&_raw, keyptr);
+#endif
+}
+
+#ifdef i_inline
+/* Inline entries are packed at the front of _inl, unordered, and searched linearly. */
+STC_INLINE cx_value_t*
+cx_memb(_inl_find_)(const Self* self, const cx_lookup_t* keyptr) {
+    cx_value_t* _val = (cx_value_t *) self->_inl, *_end = _val + self->size;
+    for (; _val != _end; ++_val) if (cx_memb(_equ_)(_val, keyptr)) return _val;
+    return NULL;
+}
+#endif
+
+STC_INLINE cx_result_t
+cx_memb(_insert_entry_)(Self* self, i_keyraw rkey) {
+    cx_lookup_t _key = cx_lookup(rkey);
+    return cx_memb(_insert_key_)(self, &_key);
 }
 
 STC_INLINE cx_result_t
@@ -147,46 +440,123 @@ cx_memb(_emplace)(Self* self, i_keyraw rkey cx_MAP_ONLY(, i_valraw rmapped)) {
     cx_result_t _res = cx_memb(_insert_entry_)(self, rkey);
     if (_res.inserted) {
         *cx_keyref(_res.ref) = i_keyfrom(rkey);
-        cx_MAP_ONLY( _res.ref->second = i_valfrom(rmapped); )
+        cx_MAP_ONLY( *cx_mapped(self, _res.ref) = i_valfrom(rmapped); )
     }
     return _res;
 }
 
 STC_INLINE cx_result_t
 cx_memb(_insert)(Self* self, i_key _key cx_MAP_ONLY(, i_val _mapped)) {
-    cx_result_t _res = cx_memb(_insert_entry_)(self, i_keyto(&_key));
-    if (_res.inserted) { *cx_keyref(_res.ref) = _key; cx_MAP_ONLY( _res.ref->second = _mapped; )}
+    cx_lookup_t _k = cx_lookup_key(&_key);
+    cx_result_t _res = cx_memb(_insert_key_)(self, &_k);
+    if (_res.inserted) { *cx_keyref(_res.ref) = _key; cx_MAP_ONLY( *cx_mapped(self, _res.ref) = _mapped; )}
     else               { i_keydel(&_key); cx_MAP_ONLY( i_valdel(&_mapped); )}
     return _res;
 }
 
+#ifdef i_incremental
+/* While the old table is being migrated, iteration continues into it
+   after the end of the new table. */
+STC_INLINE void
+cx_memb(_skip_)(cx_iter_t* it) {
+    while (*it->_hx == 0) ++it->ref, ++it->_hx;
+    if (it->_hx == it->_hxend && it->_ohx) {
+        it->ref = it->_oref, it->_hx = it->_ohx, it->_ohx = NULL;
+        while (*it->_hx == 0) ++it->ref, ++it->_hx;
+    }
+}
+
 STC_INLINE cx_iter_t
-cx_memb(_find)(const Self* self, i_keyraw rkey) {
+cx_memb(_iter_)(const Self* self, size_t idx) {
+    cx_iter_t it = {self->table + idx, self->_hashx + idx,
+                    self->_hashx + self->bucket_count, self->_ohashx, self->_otable};
+    return it;
+}
+#endif
+
+STC_INLINE cx_iter_t
+cx_memb(_find_)(const Self* self, const cx_lookup_t* keyptr) {
     cx_iter_t it = {NULL};
     if (self->size == 0) return it;
-    chash_bucket_t b = cx_memb(_bucket_)(self, &rkey);
-    if (*(it._hx = self->_hashx+b.idx)) it.ref = self->table+b.idx;
+#ifdef i_inline
+    if (cx_inl(self)) {
+        it.ref = cx_memb(_inl_find_)(self, keyptr), it._hx = (uint8_t *) _cmap_inl_hx;
+        return it;
+    }
+#endif
+    chash_bucket_t b = cx_memb(_bucket_)(self, keyptr);
+#ifdef i_incremental
+    it = cx_memb(_iter_)(self, b.idx);
+    if (cx_found(self, b)) return it;
+    if ((it.ref = self->_osize ? cx_memb(_find_old_)(self, keyptr) : NULL))
+        it._hx = self->_ohashx + (it.ref - self->_otable), it._ohx = NULL;
+#else
+    it._hx = self->_hashx + b.idx;
+    if (cx_found(self, b)) it.ref = self->table + b.idx;
+#endif
     return it;
 }
 
+STC_INLINE cx_iter_t
+cx_memb(_find)(const Self* self, i_keyraw rkey) {
+    cx_lookup_t _key = cx_lookup(rkey);
+    return cx_memb(_find_)(self, &_key);
+}
+
 STC_INLINE cx_value_t*
 cx_memb(_get)(const Self* self, i_keyraw rkey)
     { return cx_memb(_find)(self, rkey).ref; }
 
+STC_INLINE bool
+cx_memb(_contains)(const Self* self, i_keyraw rkey)
+    { return cx_memb(_find)(self, rkey).ref != NULL; }
+
+cx_MAP_ONLY(
+    STC_INLINE cx_mapped_t*
+    cx_memb(_at)(const Self* self, i_keyraw rkey)
+        { return cx_mapped(self, cx_memb(_find)(self, rkey).ref); }
+
+    /* The mapped value of an entry, e.g. it.ref. With i_soa it is not stored next to the key. */
+    STC_INLINE cx_mapped_t*
+    cx_memb(_mapped)(const Self* self, const cx_value_t* ref)
+        { return (cx_mapped_t *) cx_mapped(self, ref); }
+)
+
 STC_INLINE cx_iter_t
 cx_memb(_begin)(const Self* self) {
+#ifdef i_incremental
+    cx_iter_t it = cx_memb(_iter_)(self, 0);
+    if (it._hx) cx_memb(_skip_)(&it);
+#else
     cx_iter_t it = {self->table, self->_hashx};
+  #ifdef i_inline
+    if (cx_inl(self)) it.ref = (cx_value_t *) self->_inl, it._hx = (uint8_t *) _cmap_inl_hx;
+  #endif
     if (it._hx) while (*it._hx == 0) ++it.ref, ++it._hx;
+#endif
     return it;
 }
 
 STC_INLINE cx_iter_t
-cx_memb(_end)(const Self* self)
-    { return c_make(cx_iter_t){self->table + self->bucket_count}; }
+cx_memb(_end)(const Self* self) {
+    cx_iter_t it = {self->table + self->bucket_count};
+#ifdef i_incremental
+    if (self->_otable) it.ref = self->_otable + self->_obucket_count;
+#endif
+#ifdef i_inline
+    if (cx_inl(self)) it.ref = (cx_value_t *) self->_inl + self->size;
+#endif
+    return it;
+}
 
 STC_INLINE void
-cx_memb(_next)(cx_iter_t* it)
-    { while ((++it->ref, *++it->_hx == 0)) ; }
+cx_memb(_next)(cx_iter_t* it) {
+#ifdef i_incremental
+    ++it->ref, ++it->_hx; cx_memb(_skip_)(it);
+#else
+    while ((++it->ref, *++it->_hx == 0)) ;
+#endif
+}
 
 STC_INLINE cx_iter_t
 cx_memb(_advance)(cx_iter_t it, size_t n) {
@@ -195,13 +565,51 @@ cx_memb(_advance)(cx_iter_t it, size_t n) {
     return it;
 }
 
+STC_INLINE size_t
+cx_memb(_erase_)(Self* self, const cx_lookup_t* keyptr) {
+#ifdef i_incremental
+    if (self->_otable) cx_memb(_migrate_)(self, _cmap_MIGRATE);
+#endif
+    cx_value_t* _val = cx_memb(_find_)(self, keyptr).ref;
+    return _val ? cx_memb(_erase_entry)(self, _val), 1 : 0;
+}
+
 STC_INLINE size_t
 cx_memb(_erase)(Self* self, i_keyraw rkey) {
-    if (self->size == 0) return 0;
-    chash_bucket_t b = cx_memb(_bucket_)(self, &rkey);
-    return self->_hashx[b.idx] ? cx_memb(_erase_entry)(self, self->table + b.idx), 1 : 0;
+    cx_lookup_t _key = cx_lookup(rkey);
+    return cx_memb(_erase_)(self, &_key);
 }
 
+#ifdef i_key_str
+/* Lookups by csview: no strlen() of the key, nor a NUL-terminated copy. */
+STC_INLINE cx_iter_t
+cx_memb(_find_v)(const Self* self, csview key) { return cx_memb(_find_)(self, &key); }
+
+STC_INLINE cx_value_t*
+cx_memb(_get_v)(const Self* self, csview key) { return cx_memb(_find_)(self, &key).ref; }
+
+STC_INLINE bool
+cx_memb(_contains_v)(const Self* self, csview key) { return cx_memb(_find_)(self, &key).ref != NULL; }
+
+cx_MAP_ONLY(
+    STC_INLINE cx_mapped_t*
+    cx_memb(_at_v)(const Self* self, csview key) { return cx_mapped(self, cx_memb(_find_)(self, &key).ref); }
+)
+
+STC_INLINE cx_result_t
+cx_memb(_emplace_v)(Self* self, csview key cx_MAP_ONLY(, i_valraw rmapped)) {
+    cx_result_t _res = cx_memb(_insert_key_)(self, &key);
+    if (_res.inserted) {
+        *cx_keyref(_res.ref) = cstr_from_v(key);
+        cx_MAP_ONLY( *cx_mapped(self, _res.ref) = i_valfrom(rmapped); )
+    }
+    return _res;
+}
+
+STC_INLINE size_t
+cx_memb(_erase_v)(Self* self, csview key) { return cx_memb(_erase_)(self, &key); }
+#endif
+
 STC_INLINE cx_iter_t
 cx_memb(_erase_at)(Self* self, cx_iter_t it) {
     cx_memb(_erase_entry)(self, it.ref);
@@ -209,34 +617,52 @@ cx_memb(_erase_at)(Self* self, cx_iter_t it) {
     return it;
 }
 
-/* -------------------------- IMPLEMENTATION ------------------------- */
-
-#if !defined(STC_HEADER) && !defined(CMAP_H_INCLUDED) || defined(i_imp) && i_imp == 2
+#ifdef i_multi
+/* Equal keys are all in the probe sequence from their home bucket: find() gives the
+   first, and next_equal() steps to the following ones, until ref is NULL. */
+typedef struct { cx_iter_t first, last; } cx_memb(_range_t);
+STC_API size_t          cx_memb(_erase_all_)(Self* self, const cx_lookup_t* keyptr);
 
-STC_DEF uint64_t c_default_hash(const void *key, size_t len) {
-    const uint64_t m = 0xb5ad4eceda1ce2a9;
-    uint64_t k, h = m + len;
-    const uint8_t *p = (const uint8_t *)key, *end = p + (len & ~7ull);
-    for (; p != end; p += 8) { memcpy(&k, p, 8); h ^= m*k; }
-    switch (len & 7) {
-        case 7: h ^= (uint64_t) p[6] << 48; /* @fallthrough@ */
-        case 6: h ^= (uint64_t) p[5] << 40; /* @fallthrough@ */
-        case 5: h ^= (uint64_t) p[4] << 32; /* @fallthrough@ */
-        case 4: h ^= (uint64_t) p[3] << 24; /* @fallthrough@ */
-        case 3: h ^= (uint64_t) p[2] << 16; /* @fallthrough@ */
-        case 2: h ^= (uint64_t) p[1] << 8;  /* @fallthrough@ */
-        case 1: h ^= (uint64_t) p[0]; h *= m;
+STC_INLINE void
+cx_memb(_next_equal)(const Self* self, cx_iter_t* it) {
+    const size_t _cap = self->bucket_count;
+    const uint8_t _hx = *it->_hx;
+    cx_lookup_t _key = cx_lookup_key(cx_keyref(it->ref));
+    size_t i = it->ref - self->table;
+    for (;;) {
+        if (++i == _cap) i = 0;
+        if (self->_hashx[i] == 0) { it->ref = NULL; return; }
+        if (self->_hashx[i] == _hx cx_HASH_ONLY(&& self->_hashv[i] == self->_hashv[it->ref - self->table])
+                                   && cx_memb(_equ_)(self->table + i, &_key)) break;
     }
-    return h ^ (h >> 15);
+    it->ref = self->table + i, it->_hx = self->_hashx + i;
+}
+
+STC_INLINE cx_memb(_range_t)
+cx_memb(_equal_range)(const Self* self, i_keyraw rkey) {
+    cx_memb(_range_t) r = {cx_memb(_find)(self, rkey)};
+    return r;
+}
+
+STC_INLINE size_t
+cx_memb(_count)(const Self* self, i_keyraw rkey) {
+    size_t n = 0;
+    for (cx_iter_t it = cx_memb(_find)(self, rkey); it.ref; cx_memb(_next_equal)(self, &it)) ++n;
+    return n;
+}
+
+STC_INLINE size_t
+cx_memb(_erase_all)(Self* self, i_keyraw rkey) {
+    cx_lookup_t _key = cx_lookup(rkey);
+    return cx_memb(_erase_all_)(self, &_key);
 }
-#endif // NON-TEMPLATED
+#endif
+
+/* -------------------------- IMPLEMENTATION ------------------------- */
 
 #if !defined(STC_HEADER) || defined(STC_IMPLEMENTATION) || defined(i_imp)
 
 #ifndef CMAP_H_INCLUDED
-//STC_INLINE size_t fastrange_uint64_t(uint64_t x, uint64_t n)
-//    { uint64_t lo, hi; c_umul128(x, n, &lo, &hi); return hi; }
-#define fastrange_uint32_t(x, n) ((size_t) (((uint32_t)(x)*(uint64_t)(n)) >> 32))
 #define chash_index_(h, entryPtr) ((entryPtr) - (h).table)
 #endif
 
@@ -247,72 +673,343 @@ cx_memb(_with_capacity)(size_t cap) {
     return h;
 }
 
+STC_INLINE size_t cx_memb(_blocksize_)(size_t cap, size_t* tab) {
+    *tab = _cmap_ALIGN(cx_hxsize(cap)) cx_HASH_ONLY(+ _cmap_ALIGN(cap*sizeof(cx_size_t)));
+#ifdef i_soa
+    return *tab + _cmap_ALIGN(cap*sizeof(cx_value_t)) + cap*sizeof(cx_mapped_t);
+#else
+    return *tab + cap*sizeof(cx_value_t);
+#endif
+}
+
+STC_INLINE void cx_memb(_alloc_)(Self* m, size_t cap, bool zero) {
+    size_t tab, size = cx_memb(_blocksize_)(cap, &tab);
+    m->_hashx = (uint8_t *) cx_alloc(size, zero ? cx_hxsize(cap) : 0);
+    cx_HASH_ONLY( m->_hashv = (cx_size_t *) (m->_hashx + _cmap_ALIGN(cx_hxsize(cap))); )
+    m->table = (cx_value_t *) (m->_hashx + tab);
+    cx_SOA_ONLY( m->_vals = (cx_mapped_t *) (m->_hashx + tab + _cmap_ALIGN(cap*sizeof(cx_value_t))); )
+}
+
+STC_INLINE void cx_memb(_free_)(uint8_t* hashx, size_t cap) {
+    size_t tab;
+    if (hashx) cx_free(hashx, cx_memb(_blocksize_)(cap, &tab));
+}
+
 STC_INLINE void cx_memb(_wipe_)(Self* self) {
     if (self->size == 0) return;
     cx_value_t* e = self->table, *end = e + self->bucket_count;
     uint8_t *hx = self->_hashx;
+#ifdef i_inline
+    if (cx_inl(self)) e = self->_inl, end = e + self->size, hx = (uint8_t *) _cmap_inl_hx;
+#endif
+    for (; e != end; ++e) if (*hx++) cx_memb(_entry_del_)(self, e);
+#ifdef i_incremental
+    e = self->_otable, end = e + self->_obucket_count, hx = self->_ohashx;
     for (; e != end; ++e) if (*hx++) cx_memb(_value_del)(e);
+#endif
 }
 
+#ifdef i_incremental
+STC_INLINE void cx_memb(_free_old_)(Self* self) {
+    cx_memb(_free_)(self->_ohashx, self->_obucket_count);
+    cx_HASH_ONLY( self->_ohashv = NULL; )
+    self->_otable = NULL, self->_ohashx = NULL;
+    self->_osize = self->_obucket_count = self->_opos = 0;
+}
+
+/* The old table seen as a map of its own. */
+STC_INLINE Self cx_memb(_old_)(const Self* self) {
+    Self o = {.table = self->_otable, ._hashx = self->_ohashx, .size = self->_osize,
+              .bucket_count = self->_obucket_count, .max_load_factor = self->max_load_factor};
+    cx_HASH_ONLY( o._hashv = self->_ohashv; )
+    return o; /* not a copy of *self: the i_stats counters may be updated concurrently */
+}
+#endif
+
 STC_DEF void cx_memb(_del)(Self* self) {
+#ifdef i_persist
+    if (cx_memb(_is_mapped)(self)) { cx_memb(_unmap)(self); return; }
+#endif
     cx_memb(_wipe_)(self);
-    c_free(self->_hashx);
-    c_free((void *) self->table);
+    cx_memb(_free_)(self->_hashx, self->bucket_count);
+#ifdef i_incremental
+    cx_memb(_free_old_)(self);
+#endif
 }
 
 STC_DEF void cx_memb(_clear)(Self* self) {
+    size_t tab;
+#ifdef i_persist
+    if (cx_memb(_is_mapped)(self)) { cx_memb(_unmap)(self); return; }
+#endif
     cx_memb(_wipe_)(self);
+    if (self->size && self->bucket_count) cx_zero(self->_hashx, self->bucket_count,
+                            cx_memb(_blocksize_)(self->bucket_count, &tab));
     self->size = 0;
-    memset(self->_hashx, 0, self->bucket_count);
+#ifdef i_incremental
+    cx_memb(_free_old_)(self);
+#endif
 }
 
 STC_INLINE void cx_memb(_copy)(Self *self, Self other) {
-    if (self->table == other.table) return;
-    cx_memb(_del)(self); *self = cx_memb(_clone)(other);
+    if (self->table == other.table && other.bucket_count) return;
+    Self _tmp = cx_memb(_clone)(other); /* other may be a copy of *self */
+    cx_memb(_del)(self); *self = _tmp;
 }
 
+#ifndef i_multi
 cx_MAP_ONLY(
     STC_DEF cx_result_t
     cx_memb(_insert_or_assign)(Self* self, i_key _key, i_val _mapped) {
-        cx_result_t _res = cx_memb(_insert_entry_)(self, i_keyto(&_key));
-        if (_res.inserted) _res.ref->first = _key;
-        else { i_keydel(&_key); i_valdel(&_res.ref->second); }
-        _res.ref->second = _mapped; return _res;
+        cx_lookup_t _k = cx_lookup_key(&_key);
+        cx_result_t _res = cx_memb(_insert_key_)(self, &_k);
+        cx_mapped_t* _mp = cx_mapped(self, _res.ref);
+        if (_res.inserted) *cx_keyref(_res.ref) = _key;
+        else { i_keydel(&_key); i_valdel(_mp); }
+        *_mp = _mapped; return _res;
     }
 
     STC_DEF cx_result_t
     cx_memb(_emplace_or_assign)(Self* self, i_keyraw rkey, i_valraw rmapped) {
         cx_result_t _res = cx_memb(_insert_entry_)(self, rkey);
-        if (_res.inserted) _res.ref->first = i_keyfrom(rkey);
-        else i_valdel(&_res.ref->second);
-        _res.ref->second = i_valfrom(rmapped); return _res;
+        cx_mapped_t* _mp = cx_mapped(self, _res.ref);
+        if (_res.inserted) *cx_keyref(_res.ref) = i_keyfrom(rkey);
+        else i_valdel(_mp);
+        *_mp = i_valfrom(rmapped); return _res;
     }
 )
+#endif
+
+STC_INLINE chash_bucket_t
+cx_memb(_hash_)(const Self* self, const cx_lookup_t* keyptr) {
+#ifdef i_key_str
+    const uint64_t _hash = c_default_hash(keyptr->str, keyptr->size);
+#else
+    const uint64_t _hash = i_hash(keyptr, sizeof *keyptr);
+#endif
+    chash_bucket_t b = {cx_bucket(_hash, self->bucket_count), (uint_fast8_t)(_hash | 0x80), _hash};
+    return b;
+}
+
+STC_INLINE uint64_t
+cx_memb(_entry_hash_)(const Self* self, size_t i) {
+#ifdef i_storehash
+    return self->_hashv[i];
+#else
+    cx_lookup_t _key = cx_lookup_key(cx_keyref(self->table + i));
+    return cx_memb(_hash_)(self, &_key).hash;
+#endif
+}
+
+#ifdef i_robinhood
+/* Displacement of entry i from its home bucket. */
+STC_INLINE size_t
+cx_memb(_dist_)(const Self* self, size_t i) {
+    if (self->_hashx[i] != 255) return self->_hashx[i] - 1u;
+    size_t home = cx_bucket(cx_memb(_entry_hash_)(self, i), self->bucket_count);
+    return i >= home ? i - home : i + self->bucket_count - home;
+}
+
+/* Put an entry into bucket i at displacement d, or further on. Whenever the carried
+   entry is farther from home than the occupant, they trade places. */
+STC_INLINE void
+cx_memb(_rh_insert_)(Self* self, size_t i, size_t d, cx_value_t val cx_HASH_ONLY(, cx_size_t hv)
+                                                                     cx_SOA_ONLY(, cx_mapped_t mv)) {
+    const size_t _cap = self->bucket_count;
+    for (; self->_hashx[i]; ++d) {
+        size_t e = cx_memb(_dist_)(self, i);
+        if (e < d) {
+            c_swap(cx_value_t, self->table[i], val);
+            cx_HASH_ONLY( c_swap(cx_size_t, self->_hashv[i], hv); )
+            cx_SOA_ONLY( c_swap(cx_mapped_t, self->_vals[i], mv); )
+            self->_hashx[i] = cx_rh_hx(d);
+            d = e;
+        }
+        if (++i == _cap) i = 0;
+    }
+    self->table[i] = val;
+    self->_hashx[i] = cx_rh_hx(d);
+    cx_HASH_ONLY( self->_hashv[i] = hv; )
+    cx_SOA_ONLY( self->_vals[i] = mv; )
+}
+#elif defined i_storehash || defined i_multi
+/* First free bucket for a key known not to be in the table, or with i_multi for any key. */
+STC_INLINE size_t
+cx_memb(_free_bucket_)(const Self* self, cx_size_t _hash) {
+    size_t idx = cx_bucket(_hash, self->bucket_count);
+    while (self->_hashx[idx]) if (++idx == self->bucket_count) idx = 0;
+    return idx;
+}
+#endif
 
 STC_DEF chash_bucket_t
-cx_memb(_bucket_)(const Self* self, const cx_rawkey_t* rkeyptr) {
-    const uint64_t _hash = i_hash(rkeyptr, sizeof *rkeyptr);
+cx_memb(_bucket_)(const Self* self, const cx_lookup_t* keyptr) {
+    return cx_memb(_probe_)(self, keyptr, cx_memb(_hash_)(self, keyptr));
+}
+
+/* The probe loop. With i_stats, probe steps and i_equ calls are counted in _st[0] and _st[1]. */
+STC_INLINE chash_bucket_t
+cx_memb(_probe_s_)(const Self* self, const cx_lookup_t* keyptr, chash_bucket_t b cx_STAT_ONLY(, size_t* _st)) {
     uint_fast8_t _hx; size_t _cap = self->bucket_count;
-    chash_bucket_t b = {c_PASTE(fastrange_,MAP_SIZE_T)(_hash, _cap), (uint_fast8_t)(_hash | 0x80)};
     const uint8_t* _hashx = self->_hashx;
+#if defined i_simd && defined CMAP_SIMD_INCLUDED
+    for (;;) {
+        cx_STAT_ONLY( ++_st[0]; )
+        uint32_t _empty, _valid = _cap - b.idx < _cmap_GROUP ? (1u << (_cap - b.idx)) - 1 : ~0u;
+        uint32_t _match = _cmap_group_(_hashx + b.idx, (uint8_t) b.hx, &_empty) & _valid;
+        if ((_empty &= _valid)) _match &= (_empty & (0u - _empty)) - 1; /* only before first empty */
+        for (; _match; _match &= _match - 1) {
+            size_t i = b.idx + _cmap_ctz(_match);
+            cx_HASH_ONLY( if (self->_hashv[i] != (cx_size_t) b.hash) continue; )
+            cx_STAT_ONLY( ++_st[1]; )
+            if (cx_memb(_equ_)(self->table + i, keyptr)) { b.idx = i; return b; }
+        }
+        if (_empty) { b.idx += _cmap_ctz(_empty); return b; }
+        if ((b.idx += _cmap_GROUP) >= _cap) b.idx = 0;
+    }
+#endif
+#ifdef i_robinhood
+    /* Entries of a cluster are ordered by home bucket: stop at the first one that is closer
+       to its home than the key would be. Only entries with the key's home are compared.
+       When both displacements are saturated, the occupant's true one decides. */
+    for (size_t _d = 0; ; ++_d) { /* _d: displacement of the key at this bucket */
+        const uint_fast8_t _e = cx_rh_hx(_d);
+        int c;
+        cx_STAT_ONLY( ++_st[0]; )
+        if ((_hx = _hashx[b.idx]) != 255 || _e != 255)
+            c = (_hx > _e) - (_hx < _e);
+        else {
+            const size_t _o = cx_memb(_dist_)(self, b.idx);
+            c = (_o > _d) - (_o < _d);
+        }
+        if (c < 0) { b.hx = 0; return b; }
+        if (c == 0 cx_HASH_ONLY(&& self->_hashv[b.idx] == (cx_size_t) b.hash)) {
+            cx_STAT_ONLY( ++_st[1]; )
+            if (cx_memb(_equ_)(self->table + b.idx, keyptr)) { b.hx = 1; return b; }
+        }
+        if (++b.idx == _cap) b.idx = 0;
+    }
+#endif
+    cx_STAT_ONLY( ++_st[0]; )
     while ((_hx = _hashx[b.idx])) {
-        if (_hx == b.hx) {
-            cx_rawkey_t _raw = i_keyto(cx_keyref(self->table + b.idx));
-            if (i_equ(&_raw, rkeyptr)) break;
+        if (_hx == b.hx cx_HASH_ONLY(&& self->_hashv[b.idx] == (cx_size_t) b.hash)) {
+            cx_STAT_ONLY( ++_st[1]; )
+            if (cx_memb(_equ_)(self->table + b.idx, keyptr)) break;
         }
+        cx_STAT_ONLY( ++_st[0]; )
         if (++b.idx == _cap) b.idx = 0;
     }
     return b;
 }
 
+STC_DEF chash_bucket_t
+cx_memb(_probe_)(const Self* self, const cx_lookup_t* keyptr, chash_bucket_t b) {
+#ifdef i_stats
+    size_t _st[2] = {0, 0};
+    b = cx_memb(_probe_s_)(self, keyptr, b, _st);
+    _cmap_stat_add(&((Self *) self)->_probes, _st[0]);
+    _cmap_stat_add(&((Self *) self)->_equals, _st[1]);
+    return b;
+#else
+    return cx_memb(_probe_s_)(self, keyptr, b);
+#endif
+}
+
+/* Hash the whole batch and prefetch the home buckets first, so that
+   the cache misses of independent lookups overlap. */
+STC_INLINE size_t
+cx_memb(_find_n_)(const Self* self, const cx_rawkey_t* keys, size_t n,
+                                    cx_value_t** refs, bool* has) {
+    chash_bucket_t b[_cmap_BATCH];
+    cx_lookup_t k[_cmap_BATCH];
+    size_t i, j, m, found = 0;
+#ifdef i_inline
+    if (cx_inl(self)) {
+        for (i = 0; i < n; ++i) {
+            k[0] = cx_lookup(keys[i]);
+            cx_value_t* ref = cx_memb(_inl_find_)(self, &k[0]);
+            found += ref != NULL;
+            if (refs) refs[i] = ref;
+            if (has) has[i] = ref != NULL;
+        }
+        return found;
+    }
+#endif
+    for (i = 0; i < n; i += m) {
+        m = n - i < _cmap_BATCH ? n - i : _cmap_BATCH;
+        if (self->size) for (j = 0; j < m; ++j) {
+            k[j] = cx_lookup(keys[i + j]);
+            b[j] = cx_memb(_hash_)(self, &k[j]);
+            c_prefetch(self->_hashx + b[j].idx);
+            c_prefetch(self->table + b[j].idx);
+        }
+        for (j = 0; j < m; ++j) {
+            cx_value_t* ref = NULL;
+            if (self->size) {
+                b[j] = cx_memb(_probe_)(self, &k[j], b[j]);
+                if (cx_found(self, b[j])) ref = self->table + b[j].idx;
+            #ifdef i_incremental
+                else if (self->_osize) ref = cx_memb(_find_old_)(self, &k[j]);
+            #endif
+                found += ref != NULL;
+            }
+            if (refs) refs[i + j] = ref;
+            if (has) has[i + j] = ref != NULL;
+        }
+    }
+    return found;
+}
+
+STC_DEF size_t
+cx_memb(_get_n)(const Self* self, const cx_rawkey_t* keys, size_t n, cx_value_t** out)
+    { return cx_memb(_find_n_)(self, keys, n, out, NULL); }
+
+STC_DEF size_t
+cx_memb(_contains_n)(const Self* self, const cx_rawkey_t* keys, size_t n, bool* out)
+    { return cx_memb(_find_n_)(self, keys, n, NULL, out); }
+
 STC_DEF cx_result_t
-cx_memb(_insert_entry_)(Self* self, i_keyraw rkey) {
+cx_memb(_insert_key_)(Self* self, const cx_lookup_t* keyptr) {
+    cx_writable_(self);
+#ifdef i_inline
+    if (cx_inl(self)) {
+        cx_result_t res = {cx_memb(_inl_find_)(self, keyptr), false};
+        if (res.ref || self->size < i_inline) {
+            if (!res.ref) res.ref = self->_inl + self->size++, res.inserted = true;
+            return res;
+        }
+        cx_memb(_reserve)(self, 8 + (self->size*13ull >> 3)); /* spill to a table */
+    }
+#endif
     if (self->size + 1 >= (cx_size_t) (self->bucket_count * self->max_load_factor))
         cx_memb(_reserve)(self, 8 + (self->size*13ull >> 3));
-    chash_bucket_t b = cx_memb(_bucket_)(self, &rkey);
-    cx_result_t res = {&self->table[b.idx], !self->_hashx[b.idx]};
+#ifdef i_incremental
+    else if (self->_otable)
+        cx_memb(_migrate_)(self, _cmap_MIGRATE);
+    if (self->_osize) {
+        cx_result_t res = {cx_memb(_find_old_)(self, keyptr), false};
+        if (res.ref) return res;
+    }
+#endif
+#ifdef i_multi
+    chash_bucket_t b = cx_memb(_hash_)(self, keyptr);
+    b.idx = cx_memb(_free_bucket_)(self, (cx_size_t) b.hash);
+    cx_result_t res = {&self->table[b.idx], true};
+#else
+    chash_bucket_t b = cx_memb(_bucket_)(self, keyptr);
+    cx_result_t res = {&self->table[b.idx], !cx_found(self, b)};
+#endif
     if (res.inserted) {
+    #ifdef i_robinhood
+        size_t i = b.idx, _cap = self->bucket_count, _home = cx_bucket(b.hash, _cap);
+        if (self->_hashx[i]) /* move the occupant on, to make room */
+            cx_memb(_rh_insert_)(self, i + 1 == _cap ? 0 : i + 1, cx_memb(_dist_)(self, i) + 1,
+                                 self->table[i] cx_HASH_ONLY(, self->_hashv[i]) cx_SOA_ONLY(, self->_vals[i]));
+        self->_hashx[i] = cx_rh_hx(i >= _home ? i - _home : i + _cap - _home);
+    #else
         self->_hashx[b.idx] = b.hx;
+    #endif
+        cx_HASH_ONLY( self->_hashv[b.idx] = (cx_size_t) b.hash; )
         ++self->size;
     }
     return res;
@@ -320,67 +1017,420 @@ cx_memb(_insert_entry_)(Self* self, i_keyraw rkey) {
 
 STC_DEF Self
 cx_memb(_clone)(Self m) {
-    Self clone = {
-        c_new_n(cx_value_t, m.bucket_count),
-        (uint8_t *) memcpy(c_malloc(m.bucket_count + 1), m._hashx, m.bucket_count + 1),
-        m.size, m.bucket_count,
-        m.max_load_factor
-    };
+#ifdef i_incremental
+    if (m._otable) { /* migration in progress: rebuild into a single table */
+        Self clone = cx_memb(_with_capacity)(m.size);
+        for (cx_iter_t it = cx_memb(_begin)(&m); it.ref != cx_memb(_end)(&m).ref; cx_memb(_next)(&it)) {
+            cx_lookup_t _key = cx_lookup_key(cx_keyref(it.ref));
+            cx_memb(_value_clone)(cx_memb(_insert_key_)(&clone, &_key).ref, it.ref);
+        }
+        return clone;
+    }
+#endif
+    if (m.bucket_count == 0) { /* nothing allocated yet */
+        Self clone = _cmap_inits;
+        clone.max_load_factor = m.max_load_factor;
+    #ifdef i_inline
+        for (; clone.size < m.size; ++clone.size)
+            cx_memb(_value_clone)(clone._inl + clone.size, m._inl + clone.size);
+    #endif
+        return clone;
+    }
+    Self clone = {.size = m.size, .bucket_count = m.bucket_count, .max_load_factor = m.max_load_factor};
+    cx_memb(_alloc_)(&clone, m.bucket_count, false);
+    memcpy(clone._hashx, m._hashx, cx_hxsize(m.bucket_count));
+    cx_HASH_ONLY( memcpy(clone._hashv, m._hashv, m.bucket_count*sizeof(cx_size_t)); )
     cx_value_t *e = m.table, *end = e + m.bucket_count, *dst = clone.table;
-    for (uint8_t *hx = m._hashx; e != end; ++hx, ++e, ++dst)
-        if (*hx) cx_memb(_value_clone)(dst, e);
+    for (uint8_t *hx = m._hashx; e != end; ++hx, ++e, ++dst) if (*hx) {
+        cx_memb(_value_clone)(dst, e);
+        cx_SOA_ONLY( *cx_mapped(&clone, dst) = i_valfrom(i_valto(cx_mapped(&m, e))); )
+    }
     return clone;
 }
 
+/* Move entry i of table src into self, which does not contain its key. */
+STC_INLINE void
+cx_memb(_move_in_)(Self* self, const Self* src, size_t i) {
+#if defined i_robinhood
+    cx_memb(_rh_insert_)(self, cx_bucket(cx_memb(_entry_hash_)(src, i), self->bucket_count), 0,
+                         src->table[i] cx_HASH_ONLY(, src->_hashv[i]) cx_SOA_ONLY(, src->_vals[i]));
+#else
+  #ifdef i_storehash
+    size_t j = cx_memb(_free_bucket_)(self, src->_hashv[i]);
+    self->_hashv[j] = src->_hashv[i];
+  #elif defined i_multi /* equal keys are not merged */
+    size_t j = cx_memb(_free_bucket_)(self, (cx_size_t) cx_memb(_entry_hash_)(src, i));
+  #else
+    cx_lookup_t _key = cx_lookup_key(cx_keyref(src->table + i));
+    size_t j = cx_memb(_bucket_)(self, &_key).idx;
+  #endif
+    self->table[j] = src->table[i];
+    cx_SOA_ONLY( self->_vals[j] = src->_vals[i]; )
+    self->_hashx[j] = src->_hashx[i];
+#endif
+}
+
 STC_DEF void
 cx_memb(_reserve)(Self* self, size_t _newcap) {
+    cx_writable_(self);
     if (_newcap < self->size) return;
+#ifdef i_incremental
+    if (self->_otable) cx_memb(_migrate_)(self, ~(size_t)0);
+#endif
     size_t _oldcap = self->bucket_count;
+#ifdef i_inline
+    if (_newcap <= i_inline) { /* fits in the map: move any table entries inline */
+        size_t n = 0;
+        for (size_t i = 0; i < _oldcap; ++i)
+            if (self->_hashx[i]) self->_inl[n++] = self->table[i];
+        cx_memb(_free_)(self->_hashx, _oldcap);
+        self->table = NULL, self->_hashx = NULL, self->bucket_count = 0;
+        cx_HASH_ONLY( self->_hashv = NULL; )
+        return;
+    }
+#endif
     _newcap = (size_t) (2 + _newcap / self->max_load_factor) | 1;
-    Self _tmp = {
-        c_new_n(cx_value_t, _newcap),
-        (uint8_t *) c_calloc(_newcap + 1, sizeof(uint8_t)),
-        self->size, (cx_size_t) _newcap,
-        self->max_load_factor
-    };
+    assert(_newcap == (cx_size_t) _newcap && "too many buckets: define i_size uint64_t");
+    Self _tmp = {.size = self->size, .bucket_count = (cx_size_t) _newcap, .max_load_factor = self->max_load_factor};
+    cx_memb(_alloc_)(&_tmp, _newcap, true);
     /* Rehash: */
     _tmp._hashx[_newcap] = 0xff; c_swap(Self, *self, _tmp);
-    cx_value_t* e = _tmp.table, *_slot = self->table;
-    uint8_t* _hashx = self->_hashx;
-    for (size_t i = 0; i < _oldcap; ++i, ++e)
-        if (_tmp._hashx[i]) {
-            cx_rawkey_t _raw = i_keyto(cx_keyref(e));
-            chash_bucket_t b = cx_memb(_bucket_)(self, &_raw);
-            _slot[b.idx] = *e;
-            _hashx[b.idx] = (uint8_t) b.hx;
+    cx_STAT_ONLY( self->_rehashes = _tmp._rehashes + (_oldcap != 0); /* not the first table */
+                  self->_probes = _tmp._probes, self->_equals = _tmp._equals; )
+#ifdef i_incremental
+    if (_tmp.size) { /* keep the old table, and migrate it gradually */
+        self->_otable = _tmp.table, self->_ohashx = _tmp._hashx;
+        cx_HASH_ONLY( self->_ohashv = _tmp._hashv; )
+        self->_osize = _tmp.size, self->_obucket_count = (cx_size_t) _oldcap;
+        while (_tmp._hashx[self->_opos]) ++self->_opos; /* start at a cluster boundary */
+        cx_memb(_migrate_)(self, _cmap_MIGRATE);
+        return;
+    }
+#endif
+#ifdef i_inline
+    if (_oldcap == 0) { /* spill the inline entries */
+        self->size = 0;
+        for (size_t i = 0; i < _tmp.size; ++i) {
+            cx_lookup_t _key = cx_lookup_key(cx_keyref(_tmp._inl + i));
+            cx_value_t* _ref = cx_memb(_insert_key_)(self, &_key).ref;
+            *_ref = _tmp._inl[i];
         }
-    c_free(_tmp._hashx);
-    c_free((void *) _tmp.table);
+        return;
+    }
+#endif
+    for (size_t i = 0; i < _oldcap; ++i)
+        if (_tmp._hashx[i]) cx_memb(_move_in_)(self, &_tmp, i);
+    cx_memb(_free_)(_tmp._hashx, _oldcap);
+}
+
+#ifdef i_incremental
+STC_DEF cx_value_t*
+cx_memb(_find_old_)(const Self* self, const cx_lookup_t* keyptr) {
+    Self o = cx_memb(_old_)(self);
+#ifdef i_stats
+    size_t _st[2] = {0, 0};
+    chash_bucket_t b = cx_memb(_probe_s_)(&o, keyptr, cx_memb(_hash_)(&o, keyptr), _st);
+    _cmap_stat_add(&((Self *) self)->_probes, _st[0]);
+    _cmap_stat_add(&((Self *) self)->_equals, _st[1]);
+#else
+    chash_bucket_t b = cx_memb(_bucket_)(&o, keyptr);
+#endif
+    return cx_found(&o, b) ? o.table + b.idx : NULL;
 }
 
+/* Move whole clusters of the old table into the new table, at least n buckets.
+   Entries of clusters not yet visited keep intact probe sequences, so the old
+   table remains searchable. */
+STC_DEF void
+cx_memb(_migrate_)(Self* self, size_t n) {
+    size_t i = self->_opos, _cap = self->_obucket_count;
+    Self o = cx_memb(_old_)(self);
+    uint8_t* _hashx = self->_ohashx;
+    while (self->_osize) {
+        if (++i == _cap) i = 0;
+        if (_hashx[i]) {
+            cx_memb(_move_in_)(self, &o, i);
+            _hashx[i] = 0;
+            --self->_osize;
+        } else if (n == 0)
+            break;
+        if (n) --n;
+    }
+    self->_opos = (cx_size_t) i;
+    if (self->_osize == 0) cx_memb(_free_old_)(self);
+}
+#endif
+
 STC_DEF void
 cx_memb(_erase_entry)(Self* self, cx_value_t* _val) {
-    size_t i = chash_index_(*self, _val), j = i, k, _cap = self->bucket_count;
+    cx_writable_(self);
+#ifdef i_incremental
+    if (_val >= self->_otable && _val < self->_otable + self->_obucket_count) {
+        Self o = cx_memb(_old_)(self);
+        cx_memb(_erase_entry)(&o, _val);
+        --self->_osize, --self->size;
+        return;
+    }
+#endif
+#ifdef i_inline
+    if (cx_inl(self)) { /* the last entry fills the gap */
+        cx_memb(_value_del)(_val);
+        *_val = self->_inl[--self->size];
+        return;
+    }
+#endif
+    size_t i = chash_index_(*self, _val), j = i, _cap = self->bucket_count;
     cx_value_t* _slot = self->table;
     uint8_t* _hashx = self->_hashx;
-    cx_memb(_value_del)(&_slot[i]);
+    cx_memb(_entry_del_)(self, &_slot[i]);
     for (;;) { /* delete without leaving tombstone */
         if (++j == _cap) j = 0;
+    #ifdef i_robinhood
+        if (_hashx[j] <= 1) /* empty, or in its home bucket */
+            break;
+        _hashx[i] = cx_rh_hx(cx_memb(_dist_)(self, j) - 1);
+        _slot[i] = _slot[j];
+        cx_HASH_ONLY( self->_hashv[i] = self->_hashv[j]; )
+        cx_SOA_ONLY( self->_vals[i] = self->_vals[j]; )
+        i = j;
+    #else
         if (! _hashx[j])
             break;
-        cx_rawkey_t _raw = i_keyto(cx_keyref(_slot + j));
-        k = c_PASTE(fastrange_,MAP_SIZE_T)(i_hash(&_raw, sizeof _raw), _cap);
-        if ((j < i) ^ (k <= i) ^ (k > j)) /* is k outside (i, j]? */
-            _slot[i] = _slot[j], _hashx[i] = _hashx[j], i = j;
+        size_t k = cx_bucket(cx_memb(_entry_hash_)(self, j), _cap);
+        if ((j < i) ^ (k <= i) ^ (k > j)) { /* is k outside (i, j]? */
+            _slot[i] = _slot[j], _hashx[i] = _hashx[j];
+            cx_HASH_ONLY( self->_hashv[i] = self->_hashv[j]; )
+            cx_SOA_ONLY( self->_vals[i] = self->_vals[j]; )
+            i = j;
+        }
+    #endif
     }
     _hashx[i] = 0;
     --self->size;
 }
 
+#ifdef i_multi
+/* Erasing shifts later entries of the cluster back, but never before the erased bucket:
+   continue the scan at the same bucket. */
+STC_DEF size_t
+cx_memb(_erase_all_)(Self* self, const cx_lookup_t* keyptr) {
+    size_t n = 0;
+    if (self->size == 0) return 0;
+    chash_bucket_t b = cx_memb(_bucket_)(self, keyptr);
+    while (self->_hashx[b.idx]) {
+        if (self->_hashx[b.idx] == b.hx cx_HASH_ONLY(&& self->_hashv[b.idx] == (cx_size_t) b.hash)
+                                        && cx_memb(_equ_)(self->table + b.idx, keyptr)) {
+            cx_memb(_erase_entry)(self, self->table + b.idx);
+            ++n;
+        } else if (++b.idx == self->bucket_count)
+            b.idx = 0;
+    }
+    return n;
+}
+#endif
+
+/* Keep the entries for which pred() is true. One sweep over the table, starting after an
+   empty bucket: erased entries leave holes, and the entries behind a hole in the same
+   cluster move back to the first free bucket from their home, in probe order. */
+STC_DEF size_t
+cx_memb(_retain)(Self* self, bool (*pred)(const cx_value_t*, void*), void* ctx) {
+    cx_writable_(self);
+    const size_t _size = self->size;
+#ifdef i_inline
+    if (cx_inl(self)) {
+        cx_value_t *p = self->_inl, *end = p + _size, *q = p;
+        for (; p != end; ++p)
+            if (pred(p, ctx)) *q++ = *p;
+            else cx_memb(_value_del)(p);
+        self->size = (cx_size_t) (q - self->_inl);
+        return _size - self->size;
+    }
+#endif
+#ifdef i_incremental
+    if (self->_otable) cx_memb(_migrate_)(self, ~(size_t)0);
+#endif
+    const size_t _cap = self->bucket_count;
+    uint8_t* _hashx = self->_hashx;
+    size_t i, j, k, n, s = 0;
+    bool _holes = false;
+    if (_size == 0) return 0;
+    while (_hashx[s]) ++s;
+    for (n = 0, j = s; n < _cap; ++n) {
+        if (++j == _cap) j = 0;
+        if (! _hashx[j]) { _holes = false; continue; }
+        if (! pred(self->table + j, ctx)) {
+            cx_memb(_entry_del_)(self, self->table + j);
+            _hashx[j] = 0, _holes = true;
+            --self->size;
+            continue;
+        }
+        if (! _holes) continue;
+    #ifdef i_robinhood /* the true displacement: the byte may be saturated */
+        k = cx_memb(_dist_)(self, j);
+        k = j >= k ? j - k : j + _cap - k;
+    #else
+        k = cx_bucket(cx_memb(_entry_hash_)(self, j), _cap);
+    #endif
+        for (i = k; i != j && _hashx[i]; ) if (++i == _cap) i = 0;
+        if (i == j) continue;
+        self->table[i] = self->table[j];
+    #ifdef i_robinhood
+        _hashx[i] = cx_rh_hx(i >= k ? i - k : i + _cap - k);
+    #else
+        _hashx[i] = _hashx[j];
+    #endif
+        cx_HASH_ONLY( self->_hashv[i] = self->_hashv[j]; )
+        cx_SOA_ONLY( self->_vals[i] = self->_vals[j]; )
+        _hashx[j] = 0;
+    }
+    return _size - self->size;
+}
+
+STC_INLINE void
+cx_memb(_stats_add_)(const Self* m, chash_stats_t* st) {
+    const size_t _cap = m->bucket_count;
+    size_t i, j, n, _run = 0;
+    if (_cap) st->bytes += cx_memb(_blocksize_)(_cap, &j);
+    for (i = 0; i < _cap; ++i) if (m->_hashx[i]) {
+        j = cx_bucket(cx_memb(_entry_hash_)(m, i), _cap);
+        n = (i >= j ? i - j : i + _cap - j) + 1;
+        st->avg_probe_length += (double) n;
+        if (n > st->max_probe_length) st->max_probe_length = n;
+        ++st->probe_histogram[n < _cmap_PROBE_BINS ? n - 1 : _cmap_PROBE_BINS - 1];
+    }
+    /* Start after an empty bucket, so that a cluster wrapping around the end counts once. */
+    for (i = 0; i < _cap && m->_hashx[i]; ++i) ;
+    if (i == _cap) return;
+    for (n = 0; n < _cap; ++n) {
+        if (++i == _cap) i = 0;
+        if (m->_hashx[i]) ++_run;
+        else if (_run) {
+            ++st->clusters;
+            if (_run > st->max_cluster) st->max_cluster = _run;
+            _run = 0;
+        }
+    }
+}
+
+STC_DEF chash_stats_t
+cx_memb(_stats)(const Self* self) {
+    chash_stats_t st = {.size = self->size, .bucket_count = self->bucket_count};
+    cx_memb(_stats_add_)(self, &st);
+#ifdef i_incremental
+    if (self->_otable) {
+        Self o = cx_memb(_old_)(self);
+        cx_memb(_stats_add_)(&o, &st);
+    }
+#endif
+    if (self->size) st.avg_probe_length /= (double) self->size;
+    cx_STAT_ONLY( st.rehashes = self->_rehashes, st.probes = _cmap_stat_load(&self->_probes),
+                  st.equal_calls = _cmap_stat_load(&self->_equals); )
+    return st;
+}
+
+#ifdef i_persist
+#ifdef i_robinhood
+  #define cx_persist_flags ((sizeof(cx_size_t) == 8 ? 2u : 0u) | 4u cx_HASH_ONLY(| 1u))
+#else
+  #define cx_persist_flags ((sizeof(cx_size_t) == 8 ? 2u : 0u) cx_HASH_ONLY(| 1u))
+#endif
+/* Bytes after the image header: table, _hashx, and with i_storehash the aligned _hashv. */
+STC_INLINE size_t cx_memb(_image_bytes_)(size_t cap) {
+    const size_t _n = cap*sizeof(cx_value_t) + cx_hxsize(cap);
+    return _n cx_HASH_ONLY(+ (sizeof(cx_size_t) - _n % sizeof(cx_size_t)) % sizeof(cx_size_t) + cap*sizeof(cx_size_t));
+}
+
+STC_DEF bool
+cx_memb(_save)(const Self* self, FILE* fp) {
+#ifdef i_incremental
+    if (self->_otable) { /* migration in progress: save a single table */
+        Self _tmp = cx_memb(_clone)(*self);
+        bool _ok = cx_memb(_save)(&_tmp, fp);
+        cx_memb(_del)(&_tmp);
+        return _ok;
+    }
+#endif
+    static const uint8_t _nohx[cx_hxsize(0)] = {0xff};
+    const size_t _cap = self->bucket_count, _tsize = _cap*sizeof(cx_value_t), _hxsize = cx_hxsize(_cap);
+    size_t _pad = 0, _vsize = 0;
+    cx_HASH_ONLY( _pad = (sizeof(cx_size_t) - (_tsize + _hxsize) % sizeof(cx_size_t)) % sizeof(cx_size_t);
+                  _vsize = _cap*sizeof(cx_size_t); )
+    _cmap_image_t h = {{'S', 'T', 'C', 'c', 'm', 'a', 'p', '1'},
+                       sizeof h + _tsize + _hxsize + _pad + _vsize, _cap, self->size,
+                       (uint32_t) sizeof(cx_value_t), (uint32_t) _hxsize, cx_persist_flags,
+                       self->max_load_factor};
+    bool _ok = c_file_write(fp, &h, sizeof h) &&
+               c_file_write(fp, self->table, _tsize) &&
+               c_file_write(fp, _cap ? self->_hashx : _nohx, _hxsize) &&
+               c_file_pad(fp, _pad);
+    cx_HASH_ONLY( _ok = _ok && c_file_write(fp, self->_hashv, _vsize); )
+    return _ok;
+}
+
+/* The arrays are used in place: the map is read-only, and is released with _unmap() or _del(). */
+STC_DEF Self
+cx_memb(_map_file)(const char* path) {
+    Self m = _cmap_inits;
+    size_t _size = 0;
+    const char* p = (const char *) c_file_map(path, &_size);
+    const _cmap_image_t* h = (const _cmap_image_t *) p;
+    if (!p) return m;
+    /* The header must describe exactly this file, and leave a free bucket to end probes. */
+    if (_size < sizeof *h || memcmp(h->magic, "STCcmap1", 8) || h->file_size != _size ||
+        h->value_size != sizeof(cx_value_t) || h->flags != cx_persist_flags ||
+        h->bucket_count > _size/sizeof(cx_value_t) || h->bucket_count != (cx_size_t) h->bucket_count ||
+        h->hxsize != cx_hxsize(h->bucket_count) || (h->size && h->size >= h->bucket_count) ||
+        h->file_size != sizeof *h + cx_memb(_image_bytes_)((size_t) h->bucket_count)) {
+        c_file_unmap(p, _size);
+        return m;
+    }
+    const size_t _tsize = h->bucket_count*sizeof(cx_value_t);
+    m.table = (cx_value_t *) (p + sizeof *h);
+    m._hashx = (uint8_t *) (p + sizeof *h + _tsize);
+    cx_HASH_ONLY( m._hashv = (cx_size_t *) (p + sizeof *h + _tsize + h->hxsize +
+        (sizeof(cx_size_t) - (_tsize + h->hxsize) % sizeof(cx_size_t)) % sizeof(cx_size_t)); )
+    m.size = (cx_size_t) h->size;
+    m.bucket_count = (cx_size_t) h->bucket_count;
+    m.max_load_factor = h->max_load_factor;
+    return m;
+}
+
+STC_DEF void
+cx_memb(_unmap)(Self* self) {
+    if (self->table) {
+        const _cmap_image_t* h = (const _cmap_image_t *) self->table - 1;
+        c_file_unmap(h, h->file_size);
+    }
+    *self = cx_memb(_init)();
+}
+#undef cx_persist_flags
+#endif
+
 #endif // TEMPLATED IMPLEMENTATION
 #undef i_isset
+#undef cx_hxsize
+#undef cx_bucket
+#undef cx_INCR_ONLY
+#undef cx_HASH_ONLY
+#undef cx_STAT_ONLY
+#undef cx_INL_ONLY
+#undef cx_SOA_ONLY
+#undef cx_PAIR_ONLY
+#undef cx_mapped
+#undef cx_inl
+#undef cx_rh_hx
+#undef cx_writable_
+#undef cx_lookup_t
+#undef cx_lookup
+#undef cx_lookup_key
+#undef cx_found
+#undef cx_alloc
+#undef cx_free
+#undef cx_zero
 #undef cx_keyref
 #undef cx_MAP_ONLY
 #undef cx_SET_ONLY
+#ifndef i_more
 #include "template.h"
+#endif
 #define CMAP_H_INCLUDED
@@ -0,0 +1,48 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Tyge Løvset, NORCE, www.norceresearch.no
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+// Unordered multimap - a cmap where keys may repeat. Entries with equal keys share a probe sequence.
+/*
+#include <stdio.h>
+
+#define i_tag ii
+#define i_key int
+#define i_val int
+#include <stc/cmultimap.h>
+
+int main(void) {
+    c_auto (cmultimap_ii, m)
+    {
+        c_apply_pair(cmultimap_ii, insert, &m, {{1, 10}, {2, 20}, {1, 11}});
+        cmultimap_ii_range_t r = cmultimap_ii_equal_range(&m, 1);
+        for (cmultimap_ii_iter_t i = r.first; i.ref != r.last.ref; cmultimap_ii_next_equal(&m, &i))
+            printf("1: %d\n", i.ref->second);
+        printf("count %zu\n", cmultimap_ii_count(&m, 1));
+    }
+}
+*/
+
+#ifndef i_prefix
+#define i_prefix cmultimap_
+#endif
+#define i_multi
+#include "cmap.h"
@@ -0,0 +1,361 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Tyge Løvset, NORCE, www.norceresearch.no
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Frozen hash map: a read-only map built from a cmap with cmap_X_freeze(), using a minimal perfect hash.
+/*
+#include <stdio.h>
+#include <stc/cstr.h>
+
+#define i_key_str
+#define i_val int
+#include <stc/cphmap.h>  // defines cmap_str with cmap_str_freeze(), and cphmap_str
+
+int main(void) {
+    c_auto (cmap_str, m)
+    c_auto (cphmap_str, codes)
+    {
+        c_apply_pair(cmap_str, emplace, &m, {{"NO", 47}, {"SE", 46}, {"DK", 45}});
+        codes = cmap_str_freeze(&m);
+        printf("%d\n", *cphmap_str_at(&codes, "SE"));      // 46
+        printf("%d\n", cphmap_str_contains(&codes, "FI")); // 0
+    }
+}
+*/
+#ifndef CPHMAP_H_INCLUDED
+#include "ccommon.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define _cphmap_LAMBDA 4 /* average keys per bucket */
+#define _cphmap_SEEDS 8 /* tries before freeze() gives up */
+
+/* fmix64 of murmur3: every input bit affects every output bit. */
+STC_INLINE uint64_t _cphmap_mix(uint64_t h) {
+    h ^= h >> 33; h *= 0xff51afd7ed558ccd;
+    h ^= h >> 33; h *= 0xc4ceb9fe1a85ec53;
+    return h ^ (h >> 33);
+}
+
+/* 60% of the keys go to the first 30% of the buckets, so that the large buckets are placed
+   first, while most slots are still free. The low half of the hash selects the part. */
+STC_INLINE size_t _cphmap_bucket(uint64_t h, size_t split, size_t nbuckets) {
+    const uint64_t x = h >> 32;
+    return (uint32_t) h < 0x9999999Au ? (size_t) ((x*split) >> 32)
+                                      : split + (size_t) ((x*(nbuckets - split)) >> 32);
+}
+
+/* The slot of a key in a bucket with the given pilot. */
+STC_INLINE size_t _cphmap_pos(uint64_t h, uint32_t pilot, size_t n) {
+    return (size_t) (((_cphmap_mix(h ^ (pilot*0x9e3779b97f4a7c15)) >> 32)*n) >> 32);
+}
+
+STC_API bool _cphmap_place(const uint64_t* hash, size_t n, size_t split, size_t nbuckets,
+                           uint32_t* pilots, uint32_t* pos);
+#endif // CPHMAP_H_INCLUDED
+
+#if defined i_soa || defined i_multi
+  #error cphmap does not support i_soa or i_multi
+#endif
+#ifdef i_isset
+  #define cx_PH_SET
+  #define cx_map_t c_PASTE(cset_, i_tag)
+#else
+  #define cx_map_t c_PASTE(cmap_, i_tag)
+#endif
+#define cx_map(name) c_PASTE(cx_map_t, name)
+#undef i_prefix
+#ifdef cx_PH_SET
+  #define i_prefix cset_
+#else
+  #define i_prefix cmap_
+#endif
+#define i_more /* keep the template parameters after cmap.h */
+#include "cmap.h"
+#undef i_more
+#undef i_prefix
+#ifdef cx_PH_SET
+  #define i_prefix cphset_
+  #define cx_MAP_ONLY c_false
+  #define cx_keyref(vp) (vp)
+#else
+  #define i_prefix cphmap_
+  #define cx_MAP_ONLY c_true
+  #define cx_keyref(vp) (&(vp)->first)
+#endif
+#ifdef i_key_str
+  #define cx_lookup_t csview
+  #define cx_lookup(rkey) csview_from(rkey)
+  #define cx_lookup_key(keyp) cstr_to_v(keyp)
+#else
+  #define cx_lookup_t cx_rawkey_t
+  #define cx_lookup(rkey) (rkey)
+  #define cx_lookup_key(keyp) i_keyto(keyp)
+#endif
+
+typedef cx_map(_key_t) cx_key_t;
+typedef cx_map(_mapped_t) cx_mapped_t;
+typedef cx_map(_value_t) cx_value_t;
+typedef cx_map(_rawkey_t) cx_rawkey_t;
+typedef struct { cx_value_t *ref; } cx_iter_t;
+
+/* Entry i of the map is in table[i]. A key goes to a bucket, and the pilot of the bucket
+   gives its slot: a lookup reads one pilot and compares one key. */
+typedef struct {
+    cx_value_t* table;
+    uint32_t* _pilots;
+    size_t size, _split, _nbuckets;
+    uint64_t _seed;
+} Self;
+
+STC_API Self            cx_map(_freeze)(const cx_map_t* map);
+STC_API Self            cx_memb(_clone)(Self ph);
+STC_API void            cx_memb(_del)(Self* self);
+
+STC_INLINE Self         cx_memb(_init)(void) { Self ph = {NULL, NULL, 0, 0, 0, 0}; return ph; }
+STC_INLINE size_t       cx_memb(_size)(Self ph) { return ph.size; }
+STC_INLINE bool         cx_memb(_empty)(Self ph) { return ph.size == 0; }
+STC_INLINE size_t       cx_memb(_bucket_count)(Self ph) { return ph._nbuckets; }
+
+STC_INLINE uint64_t
+cx_memb(_hash_)(const cx_lookup_t* keyptr, uint64_t seed) {
+#ifdef i_key_str
+    return _cphmap_mix(c_default_hash(keyptr->str, keyptr->size) ^ seed);
+#else
+    return _cphmap_mix(i_hash(keyptr, sizeof *keyptr) ^ seed);
+#endif
+}
+
+/* The only slot where the key may be. */
+STC_INLINE const cx_value_t*
+cx_memb(_slot_)(const Self* self, const cx_lookup_t* keyptr) {
+    const uint64_t _hash = cx_memb(_hash_)(keyptr, self->_seed);
+    const uint32_t _pilot = self->_pilots[_cphmap_bucket(_hash, self->_split, self->_nbuckets)];
+    return self->table + _cphmap_pos(_hash, _pilot, self->size);
+}
+
+STC_INLINE const cx_value_t*
+cx_memb(_get_)(const Self* self, const cx_lookup_t* keyptr) {
+    if (self->size == 0) return NULL;
+    const cx_value_t* _val = cx_memb(_slot_)(self, keyptr);
+    return cx_map(_equ_)((cx_value_t *) _val, keyptr) ? _val : NULL;
+}
+
+STC_INLINE const cx_value_t*
+cx_memb(_get)(const Self* self, i_keyraw rkey) {
+    cx_lookup_t _key = cx_lookup(rkey);
+    return cx_memb(_get_)(self, &_key);
+}
+
+STC_INLINE bool
+cx_memb(_contains)(const Self* self, i_keyraw rkey)
+    { return cx_memb(_get)(self, rkey) != NULL; }
+
+STC_INLINE cx_iter_t
+cx_memb(_find)(const Self* self, i_keyraw rkey) {
+    const cx_value_t* _val = cx_memb(_get)(self, rkey);
+    cx_iter_t it = {(cx_value_t *) (_val ? _val : self->table + self->size)};
+    return it;
+}
+
+cx_MAP_ONLY(
+    STC_INLINE const cx_mapped_t*
+    cx_memb(_at)(const Self* self, i_keyraw rkey) {
+        const cx_value_t* _val = cx_memb(_get)(self, rkey);
+        assert(_val);
+        return &_val->second;
+    }
+)
+
+#ifdef i_key_str
+STC_INLINE const cx_value_t*
+cx_memb(_get_v)(const Self* self, csview key)
+    { return cx_memb(_get_)(self, &key); }
+
+STC_INLINE bool
+cx_memb(_contains_v)(const Self* self, csview key)
+    { return cx_memb(_get_)(self, &key) != NULL; }
+
+STC_INLINE cx_iter_t
+cx_memb(_find_v)(const Self* self, csview key) {
+    const cx_value_t* _val = cx_memb(_get_)(self, &key);
+    cx_iter_t it = {(cx_value_t *) (_val ? _val : self->table + self->size)};
+    return it;
+}
+
+cx_MAP_ONLY(
+    STC_INLINE const cx_mapped_t*
+    cx_memb(_at_v)(const Self* self, csview key) {
+        const cx_value_t* _val = cx_memb(_get_)(self, &key);
+        assert(_val);
+        return &_val->second;
+    }
+)
+#endif
+
+STC_INLINE cx_iter_t
+cx_memb(_begin)(const Self* self) {
+    cx_iter_t it = {self->table}; return it;
+}
+
+STC_INLINE cx_iter_t
+cx_memb(_end)(const Self* self) {
+    cx_iter_t it = {self->table + self->size}; return it;
+}
+
+STC_INLINE void
+cx_memb(_next)(cx_iter_t* it) { ++it->ref; }
+
+/* -------------------------- IMPLEMENTATION ------------------------- */
+
+#if !defined(STC_HEADER) || defined(STC_IMPLEMENTATION) || defined(i_imp)
+
+#ifndef CPHMAP_H_INCLUDED
+/* Find a pilot for each bucket, so that the n keys with the given hashes get distinct slots,
+   pos[i] for key i. Buckets are placed largest first; a bucket tries pilots 0, 1, ... until
+   all its keys land on free slots. False if two keys have the same hash, which no pilot
+   separates, or memory runs out. */
+STC_DEF bool
+_cphmap_place(const uint64_t* hash, size_t n, size_t split, size_t nbuckets,
+              uint32_t* pilots, uint32_t* pos) {
+    uint32_t *start = (uint32_t *) c_calloc(nbuckets + 1, sizeof *start);
+    uint32_t *keys = (uint32_t *) c_malloc(n*sizeof *keys);
+    uint32_t *order = (uint32_t *) c_malloc(nbuckets*sizeof *order), *count = NULL;
+    uint64_t *taken = (uint64_t *) c_calloc((n + 63) >> 6, sizeof *taken);
+    size_t b, i, j, maxsize = 0;
+    bool ok = start && keys && order && taken;
+    if (!ok) goto done;
+
+    /* keys sorted by bucket: bucket b has the keys keys[start[b] .. start[b + 1]) */
+    for (i = 0; i < n; ++i) ++start[_cphmap_bucket(hash[i], split, nbuckets) + 1];
+    for (b = 0; b < nbuckets; ++b) {
+        if (start[b + 1] > maxsize) maxsize = start[b + 1];
+        start[b + 1] += start[b];
+    }
+    memset(pilots, 0, nbuckets*sizeof *pilots); /* fill counts for now */
+    for (i = 0; i < n; ++i) {
+        b = _cphmap_bucket(hash[i], split, nbuckets);
+        keys[start[b] + pilots[b]++] = (uint32_t) i;
+    }
+    /* buckets by decreasing size, a counting sort */
+    ok = (count = (uint32_t *) c_calloc(maxsize + 2, sizeof *count)) != NULL;
+    if (!ok) goto done;
+    for (b = 0; b < nbuckets; ++b) ++count[maxsize - pilots[b] + 1];
+    for (i = 0; i <= maxsize; ++i) count[i + 1] += count[i];
+    for (b = 0; b < nbuckets; ++b) order[count[maxsize - pilots[b]]++] = (uint32_t) b;
+
+    for (i = 0; i < nbuckets; ++i) {
+        const size_t s = start[order[i] + 1] - start[order[i]];
+        const uint32_t* k = keys + start[order[i]];
+        uint32_t p = 0;
+        for (j = 0; j < s; ++j) {
+            size_t m = j;
+            while (++m < s) if (hash[k[j]] == hash[k[m]]) { ok = false; goto done; }
+        }
+        for (;; ++p) {
+            for (j = 0; j < s; ++j) {
+                const size_t q = _cphmap_pos(hash[k[j]], p, n);
+                if (taken[q >> 6] >> (q & 63) & 1) break;
+                taken[q >> 6] |= 1ull << (q & 63);
+                pos[k[j]] = (uint32_t) q;
+            }
+            if (j == s) break;
+            while (j--) taken[pos[k[j]] >> 6] &= ~(1ull << (pos[k[j]] & 63));
+        }
+        pilots[order[i]] = p;
+    }
+    done:
+    c_free(count); c_free(taken); c_free(order); c_free(keys); c_free(start);
+    return ok;
+}
+#endif
+
+STC_DEF Self
+cx_map(_freeze)(const cx_map_t* map) {
+    Self ph = cx_memb(_init)();
+    const size_t n = cx_map(_size)(*map);
+    if (n == 0) return ph;
+    assert(n < (1ull << 32));
+    ph._nbuckets = (n + _cphmap_LAMBDA - 1)/_cphmap_LAMBDA;
+    ph._split = ph._nbuckets*3/10;
+    ph._pilots = (uint32_t *) c_malloc(ph._nbuckets*sizeof *ph._pilots);
+    uint64_t* hash = (uint64_t *) c_malloc(n*sizeof *hash);
+    uint32_t* pos = (uint32_t *) c_malloc(n*sizeof *pos);
+    cx_value_t** src = (cx_value_t **) c_malloc(n*sizeof *src);
+    bool ok = ph._pilots && hash && pos && src;
+    if (ok) {
+        size_t i = 0;
+        c_foreach (it, cx_map_t, *map) src[i++] = it.ref;
+        ok = false;
+        for (uint64_t s = 0; !ok && s < _cphmap_SEEDS; ++s) {
+            ph._seed = s*0x9e3779b97f4a7c15;
+            for (i = 0; i < n; ++i) {
+                cx_lookup_t _key = cx_lookup_key(cx_keyref(src[i]));
+                hash[i] = cx_memb(_hash_)(&_key, ph._seed);
+            }
+            ok = _cphmap_place(hash, n, ph._split, ph._nbuckets, ph._pilots, pos);
+        }
+    }
+    if (ok) ok = (ph.table = (cx_value_t *) c_malloc(n*sizeof *ph.table)) != NULL;
+    if (ok) {
+        for (size_t i = 0; i < n; ++i)
+            cx_map(_value_clone)(ph.table + pos[i], src[i]);
+        ph.size = n;
+    } else {
+        c_free(ph._pilots);
+        ph = cx_memb(_init)();
+    }
+    c_free(src); c_free(pos); c_free(hash);
+    return ph;
+}
+
+STC_DEF Self
+cx_memb(_clone)(Self ph) {
+    Self clone = ph;
+    if (ph.size == 0) return clone;
+    clone.table = (cx_value_t *) c_malloc(ph.size*sizeof *ph.table);
+    clone._pilots = (uint32_t *) c_malloc(ph._nbuckets*sizeof *ph._pilots);
+    memcpy(clone._pilots, ph._pilots, ph._nbuckets*sizeof *ph._pilots);
+    for (size_t i = 0; i < ph.size; ++i)
+        cx_map(_value_clone)(clone.table + i, ph.table + i);
+    return clone;
+}
+
+STC_DEF void
+cx_memb(_del)(Self* self) {
+    for (size_t i = 0; i < self->size; ++i)
+        cx_map(_value_del)(self->table + i);
+    c_free(self->table);
+    c_free(self->_pilots);
+}
+
+#endif // TEMPLATED IMPLEMENTATION
+#undef cx_PH_SET
+#undef cx_map_t
+#undef cx_map
+#undef cx_MAP_ONLY
+#undef cx_keyref
+#undef cx_lookup_t
+#undef cx_lookup
+#undef cx_lookup_key
+#include "template.h"
+#define CPHMAP_H_INCLUDED
@@ -0,0 +1,43 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Tyge Løvset, NORCE, www.norceresearch.no
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Frozen hash set: a read-only set built from a cset with cset_X_freeze(), using a minimal perfect hash.
+/*
+#include <stdio.h>
+
+#define i_key int
+#include <stc/cphset.h>  // defines cset_int with cset_int_freeze(), and cphset_int
+
+int main(void) {
+    c_auto (cset_int, s)
+    c_auto (cphset_int, primes)
+    {
+        c_apply(cset_int, insert, &s, {2, 3, 5, 7, 11, 13});
+        primes = cset_int_freeze(&s);
+        printf("%d %d\n", cphset_int_contains(&primes, 7), cphset_int_contains(&primes, 9)); // 1 0
+    }
+}
+*/
+
+#define i_isset
+#include "cphmap.h"
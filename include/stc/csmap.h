@@ -59,6 +59,19 @@ struct csmap_rep { size_t root, disp, head, size, cap; void* nodes[]; };
 #define _csmap_rep(self) c_container_of((self)->nodes, struct csmap_rep, nodes)
 #endif // CSMAP_H_INCLUDED
 
+#if defined i_persist && !defined CSMAP_PERSIST_INCLUDED
+#define CSMAP_PERSIST_INCLUDED
+#include "cfilemap.h"
+/* Header of a saved tree image. The csmap_rep and its node array follow. flags records the
+   node layout, which node_size alone cannot tell apart: i_ordstat and i_multi nodes are equal in size. */
+typedef struct {
+    char magic[8];
+    uint64_t file_size;
+    uint32_t node_size, rep_size, flags;
+    char _pad[28]; /* the nodes start 32-byte aligned with a 64-bit rep */
+} _csmap_image_t;
+#endif // CSMAP_PERSIST_INCLUDED
+
 #ifndef i_prefix
 #define i_prefix csmap_
 #endif
@@ -66,15 +79,41 @@ struct csmap_rep { size_t root, disp, head, size, cap; void* nodes[]; };
   #define cx_MAP_ONLY c_false
   #define cx_SET_ONLY c_true
   #define cx_keyref(vp) (vp)
+  #define cx_rawkeyref(rvp) (rvp)
 #else
   #define cx_MAP_ONLY c_true
   #define cx_SET_ONLY c_false
   #define cx_keyref(vp) (&(vp)->first)
+  #define cx_rawkeyref(rvp) (&(rvp)->first)
 #endif
 #include "template.h"
+#ifndef i_size
+  #define i_size MAP_SIZE_T
+#endif
+#ifdef i_multi
+  /* Equal keys are ordered by a sequence number, given in insertion order: erase by
+     position needs an exact path through the tree. */
+  #define cx_MULTI_ONLY c_true
+  #define cx_seq_(vp) c_container_of(vp, cx_node_t, value)->_seq
+  #define cx_cmp_node_(d, tn, keyptr, seq) cx_memb(_cmp_seq_)(&(d)[tn], keyptr, seq)
+#else
+  #define cx_MULTI_ONLY c_false
+  #define cx_cmp_node_(d, tn, keyptr, seq) cx_memb(_cmp_)(&(d)[tn].value, keyptr)
+#endif
+#ifdef i_ordstat
+  /* Each node counts the entries of its subtree: rank and select in O(log n). */
+  #define cx_ORD_ONLY c_true
+  #define cx_recount_(d, tn) ((d)[tn]._cnt = (d)[(d)[tn].link[0]]._cnt + (d)[(d)[tn].link[1]]._cnt + 1)
+#else
+  #define cx_ORD_ONLY c_false
+  #define cx_recount_(d, tn) ((void)0)
+#endif
+#ifdef i_key_str
+  #include "csview.h"
+#endif
 
 #ifndef i_fwd
-cx_deftypes(_c_aatree_types, Self, i_key, i_val, cx_MAP_ONLY, cx_SET_ONLY);
+cx_deftypes(_c_aatree_types, Self, i_key, i_val, i_size, cx_MAP_ONLY, cx_SET_ONLY);
 #endif
 
 cx_MAP_ONLY( struct cx_value_t {
@@ -84,6 +123,8 @@ cx_MAP_ONLY( struct cx_value_t {
 struct cx_node_t {
     cx_size_t link[2];
     int8_t level;
+    cx_ORD_ONLY( cx_size_t _cnt; )
+    cx_MULTI_ONLY( cx_size_t _seq; )
     cx_value_t value;
 };
 
@@ -93,25 +134,65 @@ typedef cx_SET_ONLY( i_keyraw )
         cx_MAP_ONLY( struct { i_keyraw first; i_valraw second; } )
         cx_rawvalue_t;
 
+/* Keys are looked up through cx_lookup_t. String keys use csview, and are
+   ordered by memcmp over the shorter length, then by length, like strcmp. */
+#ifdef i_key_str
+  #define cx_lookup_t csview
+  #define cx_lookup(rkey) csview_from(rkey)
+  #define cx_lookup_key(keyp) cstr_to_v(keyp)
+#else
+  #define cx_lookup_t cx_rawkey_t
+  #define cx_lookup(rkey) (rkey)
+  #define cx_lookup_key(keyp) i_keyto(keyp)
+#endif
+
 STC_API Self            cx_memb(_init)(void);
 STC_API Self            cx_memb(_clone)(Self tree);
 STC_API void            cx_memb(_del)(Self* self);
 STC_API void            cx_memb(_reserve)(Self* self, size_t cap);
-STC_API cx_value_t*     cx_memb(_find_it)(const Self* self, i_keyraw rkey, cx_iter_t* out);
-STC_API cx_iter_t       cx_memb(_lower_bound)(const Self* self, i_keyraw rkey);
+STC_API void            cx_memb(_compact)(Self* self);
+STC_API cx_value_t*     cx_memb(_find_it_)(const Self* self, const cx_lookup_t* keyptr, cx_iter_t* out);
+STC_API cx_iter_t       cx_memb(_lower_bound_)(const Self* self, const cx_lookup_t* keyptr);
 STC_API cx_value_t*     cx_memb(_front)(const Self* self);
 STC_API cx_value_t*     cx_memb(_back)(const Self* self);
-STC_API int             cx_memb(_erase)(Self* self, i_keyraw rkey);
+STC_API int             cx_memb(_erase_)(Self* self, const cx_lookup_t* keyptr);
 STC_API cx_iter_t       cx_memb(_erase_at)(Self* self, cx_iter_t it);
 STC_API cx_iter_t       cx_memb(_erase_range)(Self* self, cx_iter_t it1, cx_iter_t it2);
-STC_API cx_result_t     cx_memb(_insert_entry_)(Self* self, i_keyraw rkey);
+STC_API size_t          cx_memb(_retain)(Self* self, bool (*pred)(const cx_value_t*, void*), void* ctx);
+STC_API Self            cx_memb(_from_sorted)(const cx_rawvalue_t* arr, size_t n);
+STC_API Self            cx_memb(_build)(cx_rawvalue_t* arr, size_t n);
+STC_API cx_result_t     cx_memb(_insert_key_)(Self* self, const cx_lookup_t* keyptr);
 STC_API void            cx_memb(_next)(cx_iter_t* it);
+#ifdef i_ordstat
+STC_API size_t          cx_memb(_rank_)(const Self* self, const cx_lookup_t* keyptr);
+STC_API cx_iter_t       cx_memb(_find_index)(const Self* self, size_t i);
+#endif
+#ifdef i_persist
+STC_API bool            cx_memb(_save)(const Self* self, FILE* fp);
+STC_API Self            cx_memb(_map_file)(const char* path);
+STC_API void            cx_memb(_unmap)(Self* self);
+
+/* An image has no free list: its disp field marks it as mapped. */
+STC_INLINE bool         cx_memb(_is_mapped)(const Self* self) { return _csmap_rep(self)->disp == ~(size_t)0; }
+  #define cx_writable_(self) assert(!cx_memb(_is_mapped)(self) && "tree from map_file() is read-only")
+#else
+  #define cx_writable_(self) ((void)0)
+#endif
 
 STC_INLINE bool         cx_memb(_empty)(Self tree) { return _csmap_rep(&tree)->size == 0; }
 STC_INLINE size_t       cx_memb(_size)(Self tree) { return _csmap_rep(&tree)->size; }
 STC_INLINE size_t       cx_memb(_capacity)(Self tree) { return _csmap_rep(&tree)->cap; }
 STC_INLINE void         cx_memb(_clear)(Self* self) { cx_memb(_del)(self); *self = cx_memb(_init)(); }
 STC_INLINE void         cx_memb(_swap)(Self* a, Self* b) { c_swap(Self, *a, *b); }
+STC_INLINE void         cx_memb(_shrink_to_fit)(Self* self) { cx_memb(_compact)(self); }
+STC_INLINE cx_value_t*  cx_memb(_find_it)(const Self* self, i_keyraw rkey, cx_iter_t* out)
+                            { cx_lookup_t key = cx_lookup(rkey); return cx_memb(_find_it_)(self, &key, out); }
+STC_INLINE cx_iter_t    cx_memb(_lower_bound)(const Self* self, i_keyraw rkey)
+                            { cx_lookup_t key = cx_lookup(rkey); return cx_memb(_lower_bound_)(self, &key); }
+STC_INLINE int          cx_memb(_erase)(Self* self, i_keyraw rkey)
+                            { cx_lookup_t key = cx_lookup(rkey); return cx_memb(_erase_)(self, &key); }
+STC_INLINE cx_result_t  cx_memb(_insert_entry_)(Self* self, i_keyraw rkey)
+                            { cx_lookup_t key = cx_lookup(rkey); return cx_memb(_insert_key_)(self, &key); }
 STC_INLINE bool         cx_memb(_contains)(const Self* self, i_keyraw rkey)
                             { cx_iter_t it; return cx_memb(_find_it)(self, rkey, &it) != NULL; }
 STC_INLINE cx_value_t*  cx_memb(_get)(const Self* self, i_keyraw rkey)
@@ -148,6 +229,37 @@ cx_memb(_value_clone)(cx_value_t* dst, cx_value_t* val) {
     cx_MAP_ONLY( dst->second = i_valfrom(i_valto(&val->second)); )
 }
 
+/* Order of two lookup keys. */
+STC_INLINE int
+cx_memb(_lookup_cmp_)(const cx_lookup_t* x, const cx_lookup_t* y) {
+#ifdef i_key_str
+    const int c = memcmp(x->str, y->str, x->size < y->size ? x->size : y->size);
+    return c ? c : (x->size > y->size) - (x->size < y->size);
+#else
+    return i_cmp(x, y);
+#endif
+}
+
+/* Order of two raw values, by key. */
+STC_INLINE int
+cx_memb(_raw_cmp_)(const cx_rawvalue_t* a, const cx_rawvalue_t* b) {
+    cx_lookup_t x = cx_lookup(*cx_rawkeyref(a)), y = cx_lookup(*cx_rawkeyref(b));
+    return cx_memb(_lookup_cmp_)(&x, &y);
+}
+
+STC_INLINE int
+cx_memb(_cmp_)(const cx_value_t* val, const cx_lookup_t* keyptr) {
+#ifdef i_key_str
+    const size_t n = cstr_size(*cx_keyref(val));
+    const int c = memcmp(cx_keyref(val)->str, keyptr->str, n < keyptr->size ? n : keyptr->size);
+    return c ? c : (n > keyptr->size) - (n < keyptr->size);
+#else
+    cx_rawkey_t raw = i_keyto(cx_keyref(val));
+    return i_cmp(&raw, keyptr);
+#endif
+}
+
+#ifndef i_multi
 cx_MAP_ONLY(
     STC_API cx_result_t cx_memb(_insert_or_assign)(Self* self, i_key key, i_val mapped);
     STC_API cx_result_t cx_memb(_emplace_or_assign)(Self* self, i_keyraw rkey, i_valraw rmapped);
@@ -155,12 +267,54 @@ cx_MAP_ONLY(
     STC_INLINE cx_result_t
     cx_memb(_put)(Self* self, i_key key, i_val mapped)
         { return cx_memb(_insert_or_assign)(self, key, mapped); }
+)
+#endif
 
+cx_MAP_ONLY(
     STC_INLINE cx_mapped_t*
     cx_memb(_at)(const Self* self, i_keyraw rkey)
         { cx_iter_t it; return &cx_memb(_find_it)(self, rkey, &it)->second; }
 )
 
+#ifdef i_multi
+STC_INLINE int
+cx_memb(_cmp_seq_)(const cx_node_t* dn, const cx_lookup_t* keyptr, cx_size_t seq) {
+    const int c = cx_memb(_cmp_)(&dn->value, keyptr);
+    return c ? c : (dn->_seq > seq) - (dn->_seq < seq);
+}
+
+typedef struct { cx_iter_t first, last; } cx_memb(_range_t);
+STC_API cx_iter_t       cx_memb(_upper_bound_)(const Self* self, const cx_lookup_t* keyptr);
+
+STC_INLINE cx_iter_t    cx_memb(_upper_bound)(const Self* self, i_keyraw rkey)
+                            { cx_lookup_t key = cx_lookup(rkey); return cx_memb(_upper_bound_)(self, &key); }
+
+/* The entries with key rkey, in insertion order: c_foreach (i, X, r.first, r.last). */
+STC_INLINE cx_memb(_range_t)
+cx_memb(_equal_range)(const Self* self, i_keyraw rkey) {
+    cx_lookup_t key = cx_lookup(rkey);
+    cx_memb(_range_t) r = {cx_memb(_lower_bound_)(self, &key), cx_memb(_upper_bound_)(self, &key)};
+    return r;
+}
+
+STC_INLINE size_t
+cx_memb(_count)(const Self* self, i_keyraw rkey) {
+    cx_lookup_t key = cx_lookup(rkey);
+    size_t n = 0;
+    cx_iter_t it;
+    for (cx_memb(_find_it_)(self, &key, &it); it.ref && cx_memb(_cmp_)(it.ref, &key) == 0; cx_memb(_next)(&it)) ++n;
+    return n;
+}
+
+STC_INLINE size_t
+cx_memb(_erase_all)(Self* self, i_keyraw rkey) {
+    cx_lookup_t key = cx_lookup(rkey);
+    size_t n = 0;
+    while (cx_memb(_erase_)(self, &key)) ++n;
+    return n;
+}
+#endif
+
 STC_INLINE cx_iter_t
 cx_memb(_find)(const Self* self, i_keyraw rkey) {
     cx_iter_t it;
@@ -186,9 +340,71 @@ cx_memb(_insert)(Self* self, i_key key cx_MAP_ONLY(, i_val mapped)) {
     return res;
 }
 
+#ifdef i_key_str
+/* Lookups by csview: no strlen() of the key, nor a NUL-terminated copy. */
+STC_INLINE cx_iter_t
+cx_memb(_find_v)(const Self* self, csview key)
+    { cx_iter_t it; cx_memb(_find_it_)(self, &key, &it); return it; }
+
+STC_INLINE cx_value_t*
+cx_memb(_get_v)(const Self* self, csview key)
+    { cx_iter_t it; return cx_memb(_find_it_)(self, &key, &it); }
+
+STC_INLINE bool
+cx_memb(_contains_v)(const Self* self, csview key)
+    { cx_iter_t it; return cx_memb(_find_it_)(self, &key, &it) != NULL; }
+
+cx_MAP_ONLY(
+    STC_INLINE cx_mapped_t*
+    cx_memb(_at_v)(const Self* self, csview key)
+        { cx_iter_t it; return &cx_memb(_find_it_)(self, &key, &it)->second; }
+)
+
+STC_INLINE cx_iter_t
+cx_memb(_lower_bound_v)(const Self* self, csview key)
+    { return cx_memb(_lower_bound_)(self, &key); }
+
+STC_INLINE cx_result_t
+cx_memb(_emplace_v)(Self* self, csview key cx_MAP_ONLY(, i_valraw rmapped)) {
+    cx_result_t res = cx_memb(_insert_key_)(self, &key);
+    if (res.inserted) {
+        *cx_keyref(res.ref) = cstr_from_v(key);
+        cx_MAP_ONLY(res.ref->second = i_valfrom(rmapped);)
+    }
+    return res;
+}
+
+STC_INLINE int
+cx_memb(_erase_v)(Self* self, csview key) { return cx_memb(_erase_)(self, &key); }
+#endif
+
+#ifdef i_ordstat
+/* Number of entries with keys less than rkey, i.e. the index of lower_bound(rkey). */
+STC_INLINE size_t
+cx_memb(_rank)(const Self* self, i_keyraw rkey)
+    { cx_lookup_t key = cx_lookup(rkey); return cx_memb(_rank_)(self, &key); }
+
+/* The i-th entry in key order, or NULL if i >= size. */
+STC_INLINE cx_value_t*
+cx_memb(_at_index)(const Self* self, size_t i)
+    { return cx_memb(_find_index)(self, i).ref; }
+
+/* Number of entries with keys in [lo, hi). */
+STC_INLINE size_t
+cx_memb(_count_range)(const Self* self, i_keyraw lo, i_keyraw hi) {
+    const size_t a = cx_memb(_rank)(self, lo), b = cx_memb(_rank)(self, hi);
+    return b > a ? b - a : 0;
+}
+
+#ifdef i_key_str
+STC_INLINE size_t
+cx_memb(_rank_v)(const Self* self, csview key) { return cx_memb(_rank_)(self, &key); }
+#endif
+#endif
+
 STC_INLINE cx_iter_t
 cx_memb(_begin)(const Self* self) {
-    cx_iter_t it; it._d = self->nodes, it._top = 0;
+    cx_iter_t it; it.ref = NULL, it._d = self->nodes, it._top = 0;
     it._tn = (cx_size_t) _csmap_rep(self)->root;
     if (it._tn) cx_memb(_next)(&it);
     return it;
@@ -237,6 +453,7 @@ cx_memb(_back)(const Self* self) {
 
 STC_DEF void
 cx_memb(_reserve)(Self* self, size_t cap) {
+    cx_writable_(self);
     struct csmap_rep* rep = _csmap_rep(self);
     cx_size_t oldcap = rep->cap;
     if (cap > oldcap) {
@@ -257,13 +474,16 @@ cx_memb(_node_new_)(Self* self, int level) {
         rep->disp = self->nodes[tn].link[1];
     } else {
         if ((tn = rep->head + 1) > rep->cap) cx_memb(_reserve)(self, 4 + (tn*13 >> 3));
+        assert(tn == (cx_size_t) tn && "too many nodes: define i_size uint64_t");
         ++_csmap_rep(self)->head; /* do after reserve */
     }
     cx_node_t* dn = &self->nodes[tn];
     dn->link[0] = dn->link[1] = 0; dn->level = level;
+    cx_ORD_ONLY( dn->_cnt = 1; )
     return (cx_size_t) tn;
 }
 
+#ifndef i_multi
 cx_MAP_ONLY(
     STC_DEF cx_result_t
     cx_memb(_insert_or_assign)(Self* self, i_key key, i_val mapped) {
@@ -281,15 +501,47 @@ cx_MAP_ONLY(
         res.ref->second = i_valfrom(rmapped); return res;
     }
 )
+#endif
 
 STC_DEF cx_value_t*
-cx_memb(_find_it)(const Self* self, i_keyraw rkey, cx_iter_t* out) {
+cx_memb(_find_it_)(const Self* self, const cx_lookup_t* keyptr, cx_iter_t* out) {
+    cx_size_t tn = _csmap_rep(self)->root;
+    cx_node_t *d = out->_d = self->nodes;
+    out->_top = 0;
+#ifdef i_multi
+    /* The first of equal keys: descend as for lower_bound. */
+    while (tn) {
+        if (cx_memb(_cmp_)(&d[tn].value, keyptr) < 0)
+            tn = d[tn].link[1];
+        else
+            { out->_st[out->_top++] = tn; tn = d[tn].link[0]; }
+    }
+    if (out->_top && cx_memb(_cmp_)(&d[tn = out->_st[out->_top - 1]].value, keyptr) == 0)
+        { --out->_top; out->_tn = d[tn].link[1]; return (out->ref = &d[tn].value); }
+#else
+    while (tn) {
+        int c;
+        if ((c = cx_memb(_cmp_)(&d[tn].value, keyptr)) < 0)
+            tn = d[tn].link[1];
+        else if (c > 0)
+            { out->_st[out->_top++] = tn; tn = d[tn].link[0]; }
+        else
+            { out->_tn = d[tn].link[1]; return (out->ref = &d[tn].value); }
+    }
+#endif
+    return (out->ref = NULL);
+}
+
+#ifdef i_multi
+/* Find the entry with key and sequence number seq. */
+STC_INLINE cx_value_t*
+cx_memb(_find_seq_)(const Self* self, const cx_lookup_t* keyptr, cx_size_t seq, cx_iter_t* out) {
     cx_size_t tn = _csmap_rep(self)->root;
     cx_node_t *d = out->_d = self->nodes;
     out->_top = 0;
     while (tn) {
-        int c; cx_rawkey_t raw = i_keyto(cx_keyref(&d[tn].value));
-        if ((c = i_cmp(&raw, &rkey)) < 0)
+        int c;
+        if ((c = cx_cmp_node_(d, tn, keyptr, seq)) < 0)
             tn = d[tn].link[1];
         else if (c > 0)
             { out->_st[out->_top++] = tn; tn = d[tn].link[0]; }
@@ -300,9 +552,67 @@ cx_memb(_find_it)(const Self* self, i_keyraw rkey, cx_iter_t* out) {
 }
 
 STC_DEF cx_iter_t
-cx_memb(_lower_bound)(const Self* self, i_keyraw rkey) {
+cx_memb(_upper_bound_)(const Self* self, const cx_lookup_t* keyptr) {
     cx_iter_t it;
-    cx_memb(_find_it)(self, rkey, &it);
+    cx_size_t tn = _csmap_rep(self)->root;
+    cx_node_t *d = it._d = self->nodes;
+    it._top = 0, it.ref = NULL;
+    while (tn) {
+        if (cx_memb(_cmp_)(&d[tn].value, keyptr) <= 0)
+            tn = d[tn].link[1];
+        else
+            { it._st[it._top++] = tn; tn = d[tn].link[0]; }
+    }
+    if (it._top) {
+        tn = it._st[--it._top];
+        it._tn = d[tn].link[1];
+        it.ref = &d[tn].value;
+    }
+    return it;
+}
+#endif
+
+#ifdef i_ordstat
+STC_DEF size_t
+cx_memb(_rank_)(const Self* self, const cx_lookup_t* keyptr) {
+    const cx_node_t *d = self->nodes;
+    cx_size_t tn = (cx_size_t) _csmap_rep(self)->root;
+    size_t r = 0;
+    while (tn) {
+        if (cx_memb(_cmp_)(&d[tn].value, keyptr) < 0)
+            { r += d[d[tn].link[0]]._cnt + 1; tn = d[tn].link[1]; }
+        else
+            tn = d[tn].link[0];
+    }
+    return r;
+}
+
+/* Iterator to the i-th entry: the descent follows the subtree counts, and leaves the
+   stack of _find_it_(), so that the iteration may continue from there. */
+STC_DEF cx_iter_t
+cx_memb(_find_index)(const Self* self, size_t i) {
+    cx_iter_t it;
+    cx_size_t tn = (cx_size_t) _csmap_rep(self)->root;
+    cx_node_t *d = it._d = self->nodes;
+    it._top = 0, it.ref = NULL;
+    if (i >= _csmap_rep(self)->size) return it;
+    while (tn) {
+        const size_t nl = d[d[tn].link[0]]._cnt;
+        if (i < nl)
+            { it._st[it._top++] = tn; tn = d[tn].link[0]; }
+        else if (i > nl)
+            { i -= nl + 1; tn = d[tn].link[1]; }
+        else
+            { it._tn = d[tn].link[1]; it.ref = &d[tn].value; break; }
+    }
+    return it;
+}
+#endif
+
+STC_DEF cx_iter_t
+cx_memb(_lower_bound_)(const Self* self, const cx_lookup_t* keyptr) {
+    cx_iter_t it;
+    cx_memb(_find_it_)(self, keyptr, &it);
     if (!it.ref && it._top) {
         cx_size_t tn = it._st[--it._top];
         it._tn = it._d[tn].link[1];
@@ -332,6 +642,7 @@ cx_memb(_skew_)(cx_node_t *d, cx_size_t tn) {
         cx_size_t tmp = d[tn].link[0];
         d[tn].link[0] = d[tmp].link[1];
         d[tmp].link[1] = tn;
+        cx_recount_(d, tn); cx_recount_(d, tmp);
         tn = tmp;
     }
     return tn;
@@ -343,6 +654,7 @@ cx_memb(_split_)(cx_node_t *d, cx_size_t tn) {
         cx_size_t tmp = d[tn].link[1];
         d[tn].link[1] = d[tmp].link[0];
         d[tmp].link[0] = tn;
+        cx_recount_(d, tn); cx_recount_(d, tmp);
         tn = tmp;
         ++d[tn].level;
     }
@@ -350,23 +662,32 @@ cx_memb(_split_)(cx_node_t *d, cx_size_t tn) {
 }
 
 STC_DEF cx_size_t
-cx_memb(_insert_entry_i_)(Self* self, cx_size_t tn, const cx_rawkey_t* rkey, cx_result_t* res) {
-    cx_size_t up[64], tx = tn;
+cx_memb(_insert_entry_i_)(Self* self, cx_size_t tn, const cx_lookup_t* keyptr, cx_result_t* res) {
+    cx_size_t up[sizeof(cx_size_t)*16], tx = tn cx_MULTI_ONLY(, seq = 0);
     cx_node_t* d = self->nodes;
     int c, top = 0, dir = 0;
     while (tx) {
         up[top++] = tx;
-        i_keyraw raw = i_keyto(cx_keyref(&d[tx].value));
-        if ((c = i_cmp(&raw, rkey)) == 0) {res->ref = &d[tx].value; return tn; }
+        c = cx_memb(_cmp_)(&d[tx].value, keyptr);
+    #ifdef i_multi
+        if ((dir = (c <= 0))) { /* after equal keys: the last one is the predecessor */
+            seq = c ? 0 : (cx_size_t) (d[tx]._seq + 1);
+            assert((c || seq) && "sequence overflow: define i_size uint64_t");
+        }
+    #else
+        if (c == 0) {res->ref = &d[tx].value; return tn; }
         dir = (c < 0);
+    #endif
         tx = d[tx].link[dir];
     }
     tx = cx_memb(_node_new_)(self, 1); d = self->nodes;
+    cx_MULTI_ONLY( d[tx]._seq = seq; )
     res->ref = &d[tx].value, res->inserted = true;
     if (top == 0) return tx;
     d[up[top - 1]].link[dir] = tx;
     while (top--) {
         if (top) dir = (d[up[top - 1]].link[1] == up[top]);
+        cx_recount_(d, up[top]);
         up[top] = cx_memb(_skew_)(d, up[top]);
         up[top] = cx_memb(_split_)(d, up[top]);
         if (top) d[up[top - 1]].link[dir] = up[top];
@@ -375,42 +696,19 @@ cx_memb(_insert_entry_i_)(Self* self, cx_size_t tn, const cx_rawkey_t* rkey, cx_
 }
 
 STC_DEF cx_result_t
-cx_memb(_insert_entry_)(Self* self, i_keyraw rkey) {
+cx_memb(_insert_key_)(Self* self, const cx_lookup_t* keyptr) {
+    cx_writable_(self);
     cx_result_t res = {NULL, false};
-    cx_size_t tn = cx_memb(_insert_entry_i_)(self, (cx_size_t) _csmap_rep(self)->root, &rkey, &res);
+    cx_size_t tn = cx_memb(_insert_entry_i_)(self, (cx_size_t) _csmap_rep(self)->root, keyptr, &res);
     _csmap_rep(self)->root = tn;
     _csmap_rep(self)->size += res.inserted;
     return res;
 }
 
+/* Restore the levels of node tn after an erase below it. */
 STC_DEF cx_size_t
-cx_memb(_erase_r_)(cx_node_t *d, cx_size_t tn, const cx_rawkey_t* rkey, int *erased) {
-    if (tn == 0)
-        return 0;
-    i_keyraw raw = i_keyto(cx_keyref(&d[tn].value));
-    cx_size_t tx; int c = i_cmp(&raw, rkey);
-    if (c != 0)
-        d[tn].link[c < 0] = cx_memb(_erase_r_)(d, d[tn].link[c < 0], rkey, erased);
-    else {
-        if (!(*erased)++)
-            cx_memb(_value_del)(&d[tn].value);
-        if (d[tn].link[0] && d[tn].link[1]) {
-            tx = d[tn].link[0];
-            while (d[tx].link[1])
-                tx = d[tx].link[1];
-            d[tn].value = d[tx].value; /* move */
-            raw = i_keyto(cx_keyref(&d[tn].value));
-            d[tn].link[0] = cx_memb(_erase_r_)(d, d[tn].link[0], &raw, erased);
-        } else { /* unlink node */
-            tx = tn;
-            tn = d[tn].link[ d[tn].link[0] == 0 ];
-            /* move it to disposed nodes list */
-            struct csmap_rep *rep = c_container_of(d, struct csmap_rep, nodes);
-            d[tx].link[1] = (cx_size_t) rep->disp;
-            rep->disp = tx;
-        }
-    }
-    tx = d[tn].link[1];
+cx_memb(_rebalance_)(cx_node_t *d, cx_size_t tn) {
+    cx_size_t tx = d[tn].link[1];
     if (d[d[tn].link[0]].level < d[tn].level - 1 || d[tx].level < d[tn].level - 1) {
         if (d[tx].level > --d[tn].level)
             d[tx].level = d[tn].level;
@@ -423,35 +721,332 @@ cx_memb(_erase_r_)(cx_node_t *d, cx_size_t tn, const cx_rawkey_t* rkey, int *era
     return tn;
 }
 
+/* Erase the node with key (and seq): one descent, which records the path, then the
+   rebalancing goes back up the path. A node with two children takes the value of its
+   predecessor, whose node is unlinked instead: no key is compared below the erased one. */
 STC_DEF int
-cx_memb(_erase)(Self* self, i_keyraw rkey) {
-    int erased = 0;
-    cx_size_t root = cx_memb(_erase_r_)(self->nodes, (cx_size_t) _csmap_rep(self)->root, &rkey, &erased);
-    return erased ? (_csmap_rep(self)->root = root, --_csmap_rep(self)->size, 1) : 0;
+cx_memb(_erase_i_)(Self* self, const cx_lookup_t* keyptr cx_MULTI_ONLY(, cx_size_t seq)) {
+    cx_writable_(self);
+    struct csmap_rep *rep = _csmap_rep(self);
+    cx_node_t *d = self->nodes;
+    cx_size_t up[sizeof(cx_size_t)*16], tn = (cx_size_t) rep->root, tx;
+    int c, top = 0, dir = 0;
+    while (tn && (c = cx_cmp_node_(d, tn, keyptr, seq)) != 0) {
+        up[top++] = tn;
+        tn = d[tn].link[c < 0];
+    }
+    if (tn == 0)
+        return 0;
+    cx_memb(_value_del)(&d[tn].value);
+    if (d[tn].link[0] && d[tn].link[1]) {
+        up[top++] = tn;
+        for (tx = d[tn].link[0]; d[tx].link[1]; tx = d[tx].link[1])
+            up[top++] = tx;
+        d[tn].value = d[tx].value; /* move */
+        cx_MULTI_ONLY( d[tn]._seq = d[tx]._seq; )
+        tn = tx;
+    }
+    tx = d[tn].link[d[tn].link[0] == 0]; /* unlink node: its child, if any, takes its place */
+    if (top) d[up[top - 1]].link[d[up[top - 1]].link[1] == tn] = tx;
+    d[tn].link[1] = (cx_size_t) rep->disp; /* move it to disposed nodes list */
+    rep->disp = tn;
+    while (top--) {
+        if (top) dir = (d[up[top - 1]].link[1] == up[top]);
+        cx_recount_(d, up[top]);
+        tx = cx_memb(_rebalance_)(d, up[top]);
+        if (top) d[up[top - 1]].link[dir] = tx;
+    }
+    rep->root = tx;
+    --rep->size;
+    return 1;
+}
+
+#ifdef i_multi
+STC_INLINE int
+cx_memb(_erase_seq_)(Self* self, const cx_lookup_t* keyptr, cx_size_t seq)
+    { return cx_memb(_erase_i_)(self, keyptr, seq); }
+
+/* Erase the first entry with the key. */
+STC_DEF int
+cx_memb(_erase_)(Self* self, const cx_lookup_t* keyptr) {
+    cx_iter_t it;
+    if (!cx_memb(_find_it_)(self, keyptr, &it)) return 0;
+    return cx_memb(_erase_seq_)(self, keyptr, cx_seq_(it.ref));
 }
 
 STC_DEF cx_iter_t
 cx_memb(_erase_at)(Self* self, cx_iter_t it) {
-    cx_rawkey_t raw = i_keyto(cx_keyref(it.ref)), nxt;
+    cx_lookup_t key = cx_lookup_key(cx_keyref(it.ref)), nxt;
+    cx_size_t seq = cx_seq_(it.ref), nseq = 0;
     cx_memb(_next)(&it);
-    if (it.ref) nxt = i_keyto(cx_keyref(it.ref));
-    cx_memb(_erase)(self, raw);
-    if (it.ref) cx_memb(_find_it)(self, nxt, &it);
+    if (it.ref) nxt = cx_lookup_key(cx_keyref(it.ref)), nseq = cx_seq_(it.ref);
+    cx_memb(_erase_seq_)(self, &key, seq);
+    if (it.ref) cx_memb(_find_seq_)(self, &nxt, nseq, &it);
     return it;
 }
+#else
+STC_DEF int
+cx_memb(_erase_)(Self* self, const cx_lookup_t* keyptr)
+    { return cx_memb(_erase_i_)(self, keyptr); }
+
+STC_DEF cx_iter_t
+cx_memb(_erase_at)(Self* self, cx_iter_t it) {
+    cx_lookup_t key = cx_lookup_key(cx_keyref(it.ref)), nxt;
+    cx_memb(_next)(&it);
+    if (it.ref) nxt = cx_lookup_key(cx_keyref(it.ref));
+    cx_memb(_erase_)(self, &key);
+    if (it.ref) cx_memb(_find_it_)(self, &nxt, &it);
+    return it;
+}
+#endif
+
+/* Join trees l < k < r with node k between them. The shorter tree, with k as its root,
+   replaces the subtree of equal level on the inner spine of the taller one, and the
+   spine is rebalanced as after an insert. */
+STC_DEF cx_size_t
+cx_memb(_join_)(cx_node_t *d, cx_size_t l, cx_size_t k, cx_size_t r) {
+    cx_size_t up[sizeof(cx_size_t)*16], tn;
+    int top = 0, dir = d[l].level > d[r].level;
+    const int lev = dir ? d[r].level : d[l].level;
+    if (d[l].level == d[r].level)
+        { d[k].link[0] = l, d[k].link[1] = r, d[k].level = lev + 1; cx_recount_(d, k); return k; }
+    for (tn = dir ? l : r; d[tn].level != lev; tn = d[tn].link[dir])
+        up[top++] = tn;
+    d[k].link[0] = dir ? tn : l, d[k].link[1] = dir ? r : tn, d[k].level = lev + 1;
+    cx_recount_(d, k);
+    d[up[top - 1]].link[dir] = k;
+    while (top--) {
+        if (top) dir = (d[up[top - 1]].link[1] == up[top]);
+        cx_recount_(d, up[top]);
+        up[top] = cx_memb(_skew_)(d, up[top]);
+        up[top] = cx_memb(_split_)(d, up[top]);
+        if (top) d[up[top - 1]].link[dir] = up[top];
+    }
+    return up[0];
+}
+
+/* Cut tree tn at the node with key (and seq), which is returned: out[0] and out[1]
+   receive the trees of the smaller and the larger keys. */
+STC_DEF cx_size_t
+cx_memb(_cut_)(cx_node_t *d, cx_size_t tn, const cx_lookup_t* keyptr cx_MULTI_ONLY(, cx_size_t seq), cx_size_t out[2]) {
+    if (tn == 0)
+        return out[0] = out[1] = 0;
+    const int c = cx_cmp_node_(d, tn, keyptr, seq);
+    cx_size_t m;
+    if (c == 0)
+        { out[0] = d[tn].link[0], out[1] = d[tn].link[1]; return tn; }
+    if (c > 0) {
+        m = cx_memb(_cut_)(d, d[tn].link[0], keyptr cx_MULTI_ONLY(, seq), out);
+        out[1] = cx_memb(_join_)(d, out[1], tn, d[tn].link[1]);
+    } else {
+        m = cx_memb(_cut_)(d, d[tn].link[1], keyptr cx_MULTI_ONLY(, seq), out);
+        out[0] = cx_memb(_join_)(d, d[tn].link[0], tn, out[0]);
+    }
+    return m;
+}
+
+/* Destroy the entries of a detached tree, and return the number of them. */
+STC_DEF size_t
+cx_memb(_drop_r_)(struct csmap_rep *rep, cx_node_t *d, cx_size_t tn) {
+    if (tn == 0) return 0;
+    size_t n = cx_memb(_drop_r_)(rep, d, d[tn].link[0]) + cx_memb(_drop_r_)(rep, d, d[tn].link[1]) + 1;
+    cx_memb(_value_del)(&d[tn].value);
+    d[tn].link[1] = (cx_size_t) rep->disp;
+    rep->disp = tn;
+    return n;
+}
 
+/* Cut out [it1, it2) as whole subtrees, and join the rest once: O(k + log n). */
 STC_DEF cx_iter_t
 cx_memb(_erase_range)(Self* self, cx_iter_t it1, cx_iter_t it2) {
-    if (!it2.ref) { while (it1.ref) it1 = cx_memb(_erase_at)(self, it1);
-                    return it1; }
-    cx_key_t k1 = *cx_keyref(it1.ref), k2 = *cx_keyref(it2.ref);
-    cx_rawkey_t r1 = i_keyto(&k1);
-    for (;;) {
-        if (memcmp(&k1, &k2, sizeof k1) == 0) return it1;
-        cx_memb(_next)(&it1); k1 = *cx_keyref(it1.ref);
-        cx_memb(_erase)(self, r1);
-        cx_memb(_find_it)(self, (r1 = i_keyto(&k1)), &it1);
+    cx_writable_(self);
+    if (!it1.ref || it1.ref == it2.ref) return it2;
+    struct csmap_rep *rep = _csmap_rep(self);
+    cx_node_t *d = self->nodes;
+    cx_size_t lo[2], hi[2] = {0, 0}, m1, m2 = 0 cx_MULTI_ONLY(, s2 = 0);
+    cx_lookup_t k1 = cx_lookup_key(cx_keyref(it1.ref)), k2;
+    m1 = cx_memb(_cut_)(d, (cx_size_t) rep->root, &k1 cx_MULTI_ONLY(, cx_seq_(it1.ref)), lo);
+    if (it2.ref) {
+        k2 = cx_lookup_key(cx_keyref(it2.ref));
+        cx_MULTI_ONLY( s2 = cx_seq_(it2.ref); )
+        m2 = cx_memb(_cut_)(d, lo[1], &k2 cx_MULTI_ONLY(, s2), hi);
+    } else
+        hi[0] = lo[1];
+    d[m1].link[0] = d[m1].link[1] = 0;
+    rep->size -= cx_memb(_drop_r_)(rep, d, m1) + cx_memb(_drop_r_)(rep, d, hi[0]);
+    rep->root = m2 ? cx_memb(_join_)(d, lo[0], m2, hi[1]) : lo[0];
+    if (m2) {
+    #ifdef i_multi
+        cx_memb(_find_seq_)(self, &k2, s2, &it2);
+    #else
+        cx_memb(_find_it_)(self, &k2, &it2);
+    #endif
+    }
+    return it2;
+}
+
+/* Link n nodes, given in key order, into a balanced tree: the middle node is the root.
+   Left subtrees are never larger than right ones, so the levels are valid for an AA-tree.
+   The nodes are tn[0..n), or first..first+n-1 if tn is NULL. */
+STC_DEF cx_size_t
+cx_memb(_build_r_)(cx_node_t* d, const cx_size_t* tn, size_t first, size_t n) {
+    if (n == 0) return 0;
+    size_t m = (n - 1)/2;
+    cx_size_t tx = tn ? tn[m] : (cx_size_t) (first + m);
+    d[tx].link[0] = cx_memb(_build_r_)(d, tn, first, m);
+    d[tx].link[1] = cx_memb(_build_r_)(d, tn ? tn + m + 1 : NULL, first + m + 1, n - 1 - m);
+    d[tx].level = d[d[tx].link[0]].level + 1;
+    cx_ORD_ONLY( d[tx]._cnt = (cx_size_t) n; )
+    return tx;
+}
+
+/* Keep the entries for which pred() is true: one in-order pass, then relink the kept nodes. */
+STC_DEF size_t
+cx_memb(_retain)(Self* self, bool (*pred)(const cx_value_t*, void*), void* ctx) {
+    cx_writable_(self);
+    struct csmap_rep *rep = _csmap_rep(self);
+    const size_t size = rep->size;
+    if (size == 0) return 0;
+    cx_node_t *d = self->nodes;
+    cx_size_t *keep = (cx_size_t *) c_malloc(size*sizeof(cx_size_t));
+    cx_size_t up[sizeof(cx_size_t)*16], tn = (cx_size_t) rep->root, tx;
+    size_t n = 0; int top = 0;
+    while (tn || top) {
+        while (tn) { up[top++] = tn; tn = d[tn].link[0]; }
+        tx = up[--top];
+        tn = d[tx].link[1];
+        if (pred(&d[tx].value, ctx))
+            keep[n++] = tx;
+        else {
+            cx_memb(_value_del)(&d[tx].value);
+            d[tx].link[1] = (cx_size_t) rep->disp;
+            rep->disp = tx;
+        }
+    }
+    rep->root = cx_memb(_build_r_)(d, keep, 0, n);
+    rep->size = n;
+    c_free(keep);
+    return size - n;
+}
+
+/* Move the entries to a new node array of exactly size nodes, in key order, and link
+   them into a balanced tree. Iteration then reads the array sequentially, and the free
+   list of erased nodes is gone. The entries themselves are not copied or destroyed. */
+STC_DEF void
+cx_memb(_compact)(Self* self) {
+    cx_writable_(self);
+    struct csmap_rep *rep = _csmap_rep(self), *nr;
+    const size_t n = rep->size;
+    if (rep->cap == 0) return;
+    if (n == 0) { c_free(rep); *self = cx_memb(_init)(); return; }
+    nr = (struct csmap_rep *) c_malloc(sizeof(struct csmap_rep) + (n + 1)*sizeof(cx_node_t));
+    cx_node_t *d = self->nodes, *e = (cx_node_t *) nr->nodes;
+    memset(nr, 0, sizeof(struct csmap_rep) + sizeof(cx_node_t));
+    cx_size_t up[sizeof(cx_size_t)*16], tn = (cx_size_t) rep->root, tx;
+    size_t i = 0; int top = 0;
+    while (tn || top) {
+        while (tn) { up[top++] = tn; tn = d[tn].link[0]; }
+        tx = up[--top];
+        tn = d[tx].link[1];
+        e[++i] = d[tx];
+    }
+    nr->root = cx_memb(_build_r_)(e, NULL, 1, n);
+    nr->head = nr->size = nr->cap = n;
+    c_free(rep);
+    self->nodes = e;
+}
+
+/* A balanced tree of entries arr[0..n) given in key order, for n > 0 and unique keys unless
+   i_multi. With idx, the entries are arr[idx[0..n)]. The shape is that of _build_r_, but nodes
+   1..n are laid out in breadth-first order, so that the top levels of the tree, which every
+   lookup visits, share cache lines. Each node keeps the range of entries of its subtree in
+   its links until it is reached, which makes the node array the queue of the traversal. */
+STC_DEF void
+cx_memb(_layout_)(Self* self, const cx_rawvalue_t* arr, const size_t* idx, size_t n) {
+    assert(n == (cx_size_t) n && "too many nodes: define i_size uint64_t");
+    cx_memb(_reserve)(self, n);
+    cx_node_t *d = self->nodes;
+    size_t tail = 2;
+    d[1].link[0] = 0, d[1].link[1] = (cx_size_t) n;
+    for (size_t i = 1; i <= n; ++i) {
+        const size_t lo = d[i].link[0], cnt = d[i].link[1], m = (cnt - 1)/2, nr = cnt - 1 - m;
+        const cx_rawvalue_t* rv = &arr[idx ? idx[lo + m] : lo + m];
+        *cx_keyref(&d[i].value) = i_keyfrom(*cx_rawkeyref(rv));
+        cx_MAP_ONLY( d[i].value.second = i_valfrom(rv->second); )
+        d[i].link[0] = m ? (cx_size_t) tail : 0;
+        if (m) d[tail].link[0] = (cx_size_t) lo, d[tail++].link[1] = (cx_size_t) m;
+        d[i].link[1] = nr ? (cx_size_t) tail : 0;
+        if (nr) d[tail].link[0] = (cx_size_t) (lo + m + 1), d[tail++].link[1] = (cx_size_t) nr;
+    }
+    for (size_t i = n; i >= 1; --i) { /* children come after their parent */
+        d[i].level = d[d[i].link[0]].level + 1;
+        cx_recount_(d, i);
+    }
+    struct csmap_rep *rep = _csmap_rep(self);
+    rep->root = 1, rep->head = rep->size = n;
+#ifdef i_multi
+    cx_iter_t it = cx_memb(_begin)(self);
+    for (cx_value_t* prev = NULL; it.ref; prev = it.ref, cx_memb(_next)(&it)) {
+        cx_lookup_t key = cx_lookup_key(cx_keyref(it.ref));
+        cx_seq_(it.ref) = prev && cx_memb(_cmp_)(prev, &key) == 0 ? cx_seq_(prev) + 1 : 0;
+    }
+#endif
+}
+
+STC_DEF Self
+cx_memb(_from_sorted)(const cx_rawvalue_t* arr, size_t n) {
+    Self tree = cx_memb(_init)();
+    size_t i, u = n != 0, *idx = NULL;
+    for (i = 1; i < n; ++i) {
+        const int c = cx_memb(_raw_cmp_)(&arr[i - 1], &arr[i]);
+        if (c > 0) break;
+        u += c < 0 cx_MULTI_ONLY(|| 1);
+    }
+    if (i < n) { /* not sorted: insert one by one */
+        for (i = 0; i < n; ++i)
+            cx_memb(_emplace)(&tree, *cx_rawkeyref(&arr[i]) cx_MAP_ONLY(, arr[i].second));
+        return tree;
+    }
+    if (u < n) { /* the first of each run of equal keys */
+        idx = (size_t *) c_malloc(u*sizeof *idx);
+        idx[0] = 0;
+        for (i = 1, u = 1; i < n; ++i)
+            if (cx_memb(_raw_cmp_)(&arr[i - 1], &arr[i]) != 0) idx[u++] = i;
+    }
+    if (u) cx_memb(_layout_)(&tree, arr, idx, u);
+    c_free(idx);
+    return tree;
+}
+
+/* Stable merge sort of arr[0..n) by key, with room for n/2 entries in tmp: entries
+   with equal keys keep their order, so build() keeps the first, or the insertion order. */
+STC_DEF void
+cx_memb(_sort_)(cx_rawvalue_t* arr, cx_rawvalue_t* tmp, size_t n) {
+    size_t i, j, k;
+    if (n <= 16) {
+        for (i = 1; i < n; ++i) {
+            cx_rawvalue_t v = arr[i];
+            for (j = i; j && cx_memb(_raw_cmp_)(&arr[j - 1], &v) > 0; --j) arr[j] = arr[j - 1];
+            arr[j] = v;
+        }
+        return;
     }
+    const size_t h = n/2;
+    cx_memb(_sort_)(arr, tmp, h);
+    cx_memb(_sort_)(arr + h, tmp, n - h);
+    if (cx_memb(_raw_cmp_)(&arr[h - 1], &arr[h]) <= 0) return;
+    memcpy(tmp, arr, h*sizeof *arr);
+    for (i = 0, j = h, k = 0; i < h && j < n; )
+        arr[k++] = cx_memb(_raw_cmp_)(&arr[j], &tmp[i]) < 0 ? arr[j++] : tmp[i++];
+    while (i < h) arr[k++] = tmp[i++];
+}
+
+STC_DEF Self
+cx_memb(_build)(cx_rawvalue_t* arr, size_t n) {
+    cx_rawvalue_t* tmp = (cx_rawvalue_t *) c_malloc((n/2 + 1)*sizeof *arr);
+    cx_memb(_sort_)(arr, tmp, n);
+    c_free(tmp);
+    return cx_memb(_from_sorted)(arr, n);
 }
 
 STC_DEF cx_size_t
@@ -459,6 +1054,8 @@ cx_memb(_clone_r_)(Self* self, cx_node_t* src, cx_size_t sn) {
     if (sn == 0) return 0;
     cx_size_t tx, tn = cx_memb(_node_new_)(self, src[sn].level);
     cx_memb(_value_clone)(&self->nodes[tn].value, &src[sn].value);
+    cx_MULTI_ONLY( self->nodes[tn]._seq = src[sn]._seq; )
+    cx_ORD_ONLY( self->nodes[tn]._cnt = src[sn]._cnt; )
     tx = cx_memb(_clone_r_)(self, src, src[sn].link[0]); self->nodes[tn].link[0] = tx;
     tx = cx_memb(_clone_r_)(self, src, src[sn].link[1]); self->nodes[tn].link[1] = tx;
     return tn;
@@ -484,16 +1081,79 @@ cx_memb(_del_r_)(cx_node_t* d, cx_size_t tn) {
 
 STC_DEF void
 cx_memb(_del)(Self* self) {
-    if (_csmap_rep(self)->root) {
+#ifdef i_persist
+    if (cx_memb(_is_mapped)(self)) { cx_memb(_unmap)(self); return; }
+#endif
+    if (_csmap_rep(self)->root)
         cx_memb(_del_r_)(self->nodes, (cx_size_t) _csmap_rep(self)->root);
+    if (_csmap_rep(self)->cap)
         c_free(_csmap_rep(self));
+}
+
+#ifdef i_persist
+#define cx_persist_flags ((sizeof(cx_size_t) == 8 ? 4u : 0u) cx_ORD_ONLY(| 1u) cx_MULTI_ONLY(| 2u))
+STC_DEF bool
+cx_memb(_save)(const Self* self, FILE* fp) {
+    struct csmap_rep r = *_csmap_rep(self);
+    const size_t _nsize = (r.head + 1)*sizeof(cx_node_t);
+    _csmap_image_t h = {.magic = {'S', 'T', 'C', 's', 'm', 'a', 'p', '3'},
+                        .file_size = sizeof h + sizeof r + _nsize, .node_size = (uint32_t) sizeof(cx_node_t),
+                        .rep_size = (uint32_t) sizeof r, .flags = cx_persist_flags};
+    r.cap = r.head; /* the mapped node array cannot grow */
+    r.disp = ~(size_t)0; /* nor reuse nodes: this marks it as mapped */
+    return c_file_write(fp, &h, sizeof h) && c_file_write(fp, &r, sizeof r) &&
+           (_csmap_rep(self)->cap ? c_file_write(fp, self->nodes, _nsize)
+                                  : c_file_pad(fp, _nsize)); /* node 0 of the empty tree */
+}
+
+/* The node array is used in place: the tree is read-only, and is released with _unmap() or _del(). */
+STC_DEF Self
+cx_memb(_map_file)(const char* path) {
+    Self tree = cx_memb(_init)();
+    size_t _size = 0;
+    const char* p = (const char *) c_file_map(path, &_size);
+    const _csmap_image_t* h = (const _csmap_image_t *) p;
+    if (!p) return tree;
+    const struct csmap_rep* r = (const struct csmap_rep *) (p + sizeof *h);
+    /* The rep must describe exactly the node array in this file, so node indices stay inside it. */
+    if (_size < sizeof *h + sizeof *r || memcmp(h->magic, "STCsmap3", 8) || h->file_size != _size ||
+        h->node_size != sizeof(cx_node_t) || h->rep_size != sizeof *r || h->flags != cx_persist_flags ||
+        r->head >= _size/sizeof(cx_node_t) || r->cap != r->head || r->disp != ~(size_t)0 ||
+        r->root > r->head || r->size > r->head || r->head != (cx_size_t) r->head ||
+        h->file_size != sizeof *h + sizeof *r + (r->head + 1)*sizeof(cx_node_t)) {
+        c_file_unmap(p, _size);
+        return tree;
     }
+    tree.nodes = (cx_node_t *) r->nodes;
+    return tree;
 }
 
+STC_DEF void
+cx_memb(_unmap)(Self* self) {
+    struct csmap_rep* rep = _csmap_rep(self);
+    if (rep != &_csmap_sentinel) {
+        const _csmap_image_t* h = (const _csmap_image_t *) (void *) rep - 1;
+        c_file_unmap(h, h->file_size);
+    }
+    *self = cx_memb(_init)();
+}
+#undef cx_persist_flags
+#endif
+
 #endif // IMPLEMENTATION
 #undef i_isset
 #undef cx_keyref
+#undef cx_rawkeyref
+#undef cx_MULTI_ONLY
+#undef cx_ORD_ONLY
+#undef cx_recount_
+#undef cx_writable_
+#undef cx_seq_
+#undef cx_cmp_node_
 #undef cx_MAP_ONLY
 #undef cx_SET_ONLY
+#undef cx_lookup_t
+#undef cx_lookup
+#undef cx_lookup_key
 #include "template.h"
 #define CSMAP_H_INCLUDED
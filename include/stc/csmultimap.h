@@ -0,0 +1,48 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Tyge Løvset, NORCE, www.norceresearch.no
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+// Sorted multimap - a csmap where keys may repeat. Entries with equal keys are kept in insertion order.
+/*
+#include <stdio.h>
+
+#define i_tag ii
+#define i_key int
+#define i_val int
+#include <stc/csmultimap.h>
+
+int main(void) {
+    c_auto (csmultimap_ii, m)
+    {
+        c_apply_pair(csmultimap_ii, insert, &m, {{1, 10}, {2, 20}, {1, 11}});
+        csmultimap_ii_range_t r = csmultimap_ii_equal_range(&m, 1);
+        c_foreach (i, csmultimap_ii, r.first, r.last)
+            printf("1: %d\n", i.ref->second);
+        printf("count %zu\n", csmultimap_ii_count(&m, 1));
+    }
+}
+*/
+
+#ifndef i_prefix
+#define i_prefix csmultimap_
+#endif
+#define i_multi
+#include "csmap.h"
@@ -0,0 +1,281 @@
+/* MIT License
+ *
+ * Copyright (c) 2021 Tyge Løvset, NORCE, www.norceresearch.no
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/* csnap: read-mostly snapshot of a container. Writers publish immutable versions
+   through an atomic pointer; readers get a consistent version without locking.
+   Retired versions are released when no reader that could see them is active.
+#include <stdio.h>
+
+#define i_tag ii
+#define i_key int
+#define i_val int
+#include <stc/cmap.h>
+
+#define i_tag ii
+#define i_val cmap_ii
+#define i_valdel cmap_ii_del
+#define i_valfrom cmap_ii_clone
+#include <stc/csnap.h>  // also defines csptr_ii
+
+int main() {
+    csnap_ii snap = csnap_ii_make(cmap_ii_init());
+    csnap_reader_t* r = csnap_ii_register(&snap);   // once per reader thread
+
+    cmap_ii next = csnap_ii_clone_current(&snap);    // writer: copy, modify, publish
+    cmap_ii_emplace(&next, 1, 10);
+    csnap_ii_publish(&snap, next);
+
+    const cmap_ii* m = csnap_ii_read_lock(&snap, r); // reader: no locks taken
+    printf("%d\n", *cmap_ii_at(m, 1));
+    csnap_ii_read_unlock(r);
+
+    csnap_ii_unregister(r);
+    csnap_ii_del(&snap);
+}
+*/
+
+#ifndef CSNAP_H_INCLUDED
+#define CSNAP_H_INCLUDED
+#include "ccommon.h"
+#include <stdint.h>
+
+#define _csnap_READERS 64 /* default max. registered readers */
+#define _csnap_SPINS 64   /* pause-spins before yielding the cpu */
+
+/* A reader slot: the epoch it entered its read section in, or 0 when outside. */
+typedef struct { int64_t epoch; long used; char _pad[64 - 8 - sizeof(long)]; } csnap_reader_t;
+
+#if defined(_MSC_VER) && !defined(__clang__)
+  #include <intrin.h>
+  STC_INLINE void* _csnap_loadp(void* volatile* p) { return *p; }
+  STC_INLINE void* _csnap_xchgp(void* volatile* p, void* v) { return _InterlockedExchangePointer(p, v); }
+  STC_INLINE int64_t _csnap_load(volatile int64_t* p) { return *p; }
+  STC_INLINE void _csnap_store_sc(volatile int64_t* p, int64_t v) { _InterlockedExchange64(p, v); }
+  STC_INLINE void _csnap_store_rel(volatile int64_t* p, int64_t v) { *p = v; }
+  STC_INLINE int64_t _csnap_inc(volatile int64_t* p) { return _InterlockedIncrement64(p); }
+  STC_INLINE bool _csnap_trylock(volatile long* p) { return _InterlockedCompareExchange(p, 1, 0) == 0; }
+  STC_INLINE void _csnap_unlock(volatile long* p) { _InterlockedExchange(p, 0); }
+  STC_INLINE long _csnap_locked(volatile long* p) { return *p; }
+#else
+  STC_INLINE void* _csnap_loadp(void** p) { return __atomic_load_n(p, __ATOMIC_SEQ_CST); }
+  STC_INLINE void* _csnap_xchgp(void** p, void* v) { return __atomic_exchange_n(p, v, __ATOMIC_SEQ_CST); }
+  STC_INLINE int64_t _csnap_load(int64_t* p) { return __atomic_load_n(p, __ATOMIC_SEQ_CST); }
+  STC_INLINE void _csnap_store_sc(int64_t* p, int64_t v) { __atomic_store_n(p, v, __ATOMIC_SEQ_CST); }
+  STC_INLINE void _csnap_store_rel(int64_t* p, int64_t v) { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+  STC_INLINE int64_t _csnap_inc(int64_t* p) { return __atomic_add_fetch(p, 1, __ATOMIC_SEQ_CST); }
+  STC_INLINE bool _csnap_trylock(long* p) {
+      long zero = 0;
+      return __atomic_compare_exchange_n(p, &zero, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+  }
+  STC_INLINE void _csnap_unlock(long* p) { __atomic_store_n(p, 0, __ATOMIC_RELEASE); }
+  STC_INLINE long _csnap_locked(long* p) { return __atomic_load_n(p, __ATOMIC_RELAXED); }
+#endif
+#if defined __SSE2__ || defined _M_X64 || defined _M_IX86
+  #include <emmintrin.h>
+  #define _csnap_pause() _mm_pause()
+#else
+  #define _csnap_pause() ((void) 0)
+#endif
+#if defined __unix__ || defined __APPLE__
+  #include <sched.h>
+  #define _csnap_yield() ((void) sched_yield())
+#else
+  #define _csnap_yield() _csnap_pause()
+#endif
+
+/* Writers wait on a plain load, pausing and then yielding, as ccmap's shard lock:
+   a writer may hold the lock while it frees retired versions. */
+STC_INLINE void _csnap_wlock(long* lock) {
+    while (!_csnap_trylock(lock)) {
+        int n = 0;
+        while (_csnap_locked(lock))
+            if (++n < _csnap_SPINS) _csnap_pause();
+            else n = 0, _csnap_yield();
+    }
+}
+
+STC_INLINE void csnap_read_unlock(csnap_reader_t* r) { _csnap_store_rel(&r->epoch, 0); }
+STC_INLINE void csnap_unregister(csnap_reader_t* r) { _csnap_unlock(&r->used); }
+#endif // CSNAP_H_INCLUDED
+
+#ifndef i_cmp
+  #define i_cmp c_no_compare
+#endif
+#define i_more /* keep the template parameters after csptr.h */
+#include "csptr.h"
+#undef i_more
+#undef i_prefix
+#define i_prefix csnap_
+#define cx_sptr_t c_PASTE(csptr_, i_tag)
+#define cx_sptr(name) c_PASTE(cx_sptr_t, name)
+
+typedef i_val cx_value_t;
+typedef cx_sptr_t cx_memb(_sptr_t);
+typedef struct cx_memb(_version_) {
+    cx_sptr_t ptr;
+    int64_t retired; /* epoch at which it was replaced */
+    struct cx_memb(_version_)* next;
+} cx_memb(_version_t);
+
+typedef struct {
+    cx_memb(_version_t)* current;
+    cx_memb(_version_t)* retired;
+    csnap_reader_t* readers;
+    size_t nreaders;
+    int64_t epoch;
+    long wlock;
+} Self;
+
+STC_API Self            cx_memb(_with_readers)(cx_value_t val, size_t max_readers);
+STC_API void            cx_memb(_del)(Self* self);
+STC_API csnap_reader_t* cx_memb(_register)(Self* self);
+STC_API void            cx_memb(_publish)(Self* self, cx_value_t val);
+STC_API cx_value_t      cx_memb(_clone_current)(Self* self);
+STC_API size_t          cx_memb(_reclaim)(Self* self);
+STC_API void            cx_memb(_synchronize)(Self* self);
+
+STC_INLINE Self cx_memb(_make)(cx_value_t val)
+    { return cx_memb(_with_readers)(val, _csnap_READERS); }
+
+STC_INLINE void cx_memb(_unregister)(csnap_reader_t* r) { csnap_unregister(r); }
+
+/* Enter a read section. The returned version stays valid until read_unlock(). */
+STC_INLINE const cx_value_t*
+cx_memb(_read_lock)(Self* self, csnap_reader_t* r) {
+    _csnap_store_sc(&r->epoch, _csnap_load(&self->epoch));
+    return ((cx_memb(_version_t) *) _csnap_loadp((void **) &self->current))->ptr.get;
+}
+
+STC_INLINE void cx_memb(_read_unlock)(csnap_reader_t* r) { csnap_read_unlock(r); }
+
+/* Shared ownership of the current version, for use outside of a read section. */
+STC_INLINE cx_sptr_t
+cx_memb(_acquire)(Self* self, csnap_reader_t* r) {
+    _csnap_store_sc(&r->epoch, _csnap_load(&self->epoch));
+    cx_sptr_t ptr = cx_sptr(_clone)(((cx_memb(_version_t) *) _csnap_loadp((void **) &self->current))->ptr);
+    csnap_read_unlock(r);
+    return ptr;
+}
+
+// -------------------------- IMPLEMENTATION -------------------------
+
+#if !defined(STC_HEADER) || defined(STC_IMPLEMENTATION) || defined(i_imp)
+
+STC_INLINE void cx_memb(_wlock_)(Self* self)
+    { _csnap_wlock(&self->wlock); }
+
+STC_DEF Self
+cx_memb(_with_readers)(cx_value_t val, size_t max_readers) {
+    Self snap = {c_new(cx_memb(_version_t)), NULL, c_new_n(csnap_reader_t, max_readers), max_readers, 1, 0};
+    snap.current->ptr = cx_sptr(_make)(val);
+    snap.current->next = NULL;
+    c_forrange (i, max_readers) snap.readers[i].epoch = 0, snap.readers[i].used = 0;
+    return snap;
+}
+
+STC_DEF void
+cx_memb(_del)(Self* self) {
+    cx_memb(_version_t)* v = self->retired;
+    while (v) {
+        cx_memb(_version_t)* next = v->next;
+        cx_sptr(_del)(&v->ptr);
+        c_free(v); v = next;
+    }
+    cx_sptr(_del)(&self->current->ptr);
+    c_free(self->current);
+    c_free(self->readers);
+}
+
+STC_DEF csnap_reader_t*
+cx_memb(_register)(Self* self) {
+    c_forrange (i, self->nreaders)
+        if (_csnap_trylock(&self->readers[i].used))
+            return &self->readers[i];
+    return NULL;
+}
+
+/* A version retired at epoch E may still be read by readers that entered before E. */
+STC_INLINE size_t
+cx_memb(_reclaim_)(Self* self) {
+    int64_t oldest = INT64_MAX, e;
+    c_forrange (i, self->nreaders)
+        if ((e = _csnap_load(&self->readers[i].epoch)) && e < oldest)
+            oldest = e;
+    size_t n = 0;
+    cx_memb(_version_t)** pv = &self->retired;
+    while (*pv) {
+        cx_memb(_version_t)* v = *pv;
+        if (v->retired <= oldest) {
+            *pv = v->next;
+            cx_sptr(_del)(&v->ptr);
+            c_free(v); ++n;
+        } else
+            pv = &v->next;
+    }
+    return n;
+}
+
+STC_DEF void
+cx_memb(_publish)(Self* self, cx_value_t val) {
+    cx_memb(_version_t)* v = c_new(cx_memb(_version_t));
+    v->ptr = cx_sptr(_make)(val);
+    v->next = NULL;
+    cx_memb(_wlock_)(self);
+    cx_memb(_version_t)* old = (cx_memb(_version_t) *) _csnap_xchgp((void **) &self->current, v);
+    old->retired = _csnap_inc(&self->epoch);
+    old->next = self->retired, self->retired = old;
+    cx_memb(_reclaim_)(self);
+    _csnap_unlock(&self->wlock);
+}
+
+STC_DEF cx_value_t
+cx_memb(_clone_current)(Self* self) {
+    cx_memb(_wlock_)(self); /* only writers retire versions */
+    cx_value_t val = i_valfrom(i_valto(self->current->ptr.get));
+    _csnap_unlock(&self->wlock);
+    return val;
+}
+
+STC_DEF size_t
+cx_memb(_reclaim)(Self* self) {
+    cx_memb(_wlock_)(self);
+    size_t n = cx_memb(_reclaim_)(self);
+    _csnap_unlock(&self->wlock);
+    return n;
+}
+
+STC_DEF void
+cx_memb(_synchronize)(Self* self) {
+    for (;;) {
+        cx_memb(_wlock_)(self);
+        cx_memb(_reclaim_)(self);
+        bool done = self->retired == NULL;
+        _csnap_unlock(&self->wlock);
+        if (done) return;
+    }
+}
+
+#endif // TEMPLATED IMPLEMENTATION
+#undef cx_sptr_t
+#undef cx_sptr
+#include "template.h"
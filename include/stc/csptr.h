@@ -176,4 +176,6 @@ cx_memb(_compare)(const Self* x, const Self* y) {
 #undef cx_increment
 #undef cx_decrement
 #undef i_nonatomic
-#include "template.h"
\ No newline at end of file
+#ifndef i_more
+#include "template.h"
+#endif
\ No newline at end of file
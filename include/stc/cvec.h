@@ -89,6 +89,7 @@ STC_API cx_iter_t       cx_memb(_find_in)(cx_iter_t it1, cx_iter_t it2, i_valraw
 STC_API cx_iter_t       cx_memb(_bsearch_in)(cx_iter_t it1, cx_iter_t it2, i_valraw raw);
 STC_API cx_value_t*     cx_memb(_push_back)(Self* self, i_val value);
 STC_API cx_iter_t       cx_memb(_erase_range_p)(Self* self, cx_value_t* p1, cx_value_t* p2);
+STC_API size_t          cx_memb(_retain)(Self* self, bool (*pred)(const cx_value_t*, void*), void* ctx);
 STC_API cx_iter_t       cx_memb(_insert_range_p)(Self* self, cx_value_t* pos,
                                                  const cx_value_t* p1, const cx_value_t* p2, bool clone);
 STC_API cx_iter_t       cx_memb(_emplace_range_p)(Self* self, cx_value_t* pos,
@@ -322,6 +323,19 @@ cx_memb(_emplace_range_p)(Self* self, cx_value_t* pos, const cx_rawvalue_t* p1,
     return it;
 }
 
+/* Keep the elements for which pred() is true, in order, in one pass. */
+STC_DEF size_t
+cx_memb(_retain)(Self* self, bool (*pred)(const cx_value_t*, void*), void* ctx) {
+    cx_value_t *p = self->data, *end = p + cvec_rep_(self)->size, *q;
+    while (p != end && pred(p, ctx)) ++p;
+    for (q = p; p != end; ++p)
+        if (pred(p, ctx)) *q++ = *p;
+        else i_valdel(p);
+    size_t n = end - q;
+    if (n) cvec_rep_(self)->size -= n;
+    return n;
+}
+
 STC_DEF cx_iter_t
 cx_memb(_erase_range_p)(Self* self, cx_value_t* p1, cx_value_t* p2) {
     intptr_t len = p2 - p1;
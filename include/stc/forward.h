@@ -29,10 +29,12 @@
 #define forward_carr3(CX, VAL) _c_carr3_types(CX, VAL)
 #define forward_cdeq(CX, VAL) _c_cdeq_types(CX, VAL)
 #define forward_clist(CX, VAL) _c_clist_types(CX, VAL)
-#define forward_cmap(CX, KEY, VAL) _c_chash_types(CX, KEY, VAL, c_true, c_false)
-#define forward_csmap(CX, KEY, VAL) _c_aatree_types(CX, KEY, VAL, c_true, c_false)
-#define forward_cset(CX, KEY) _c_chash_types(CX, cset, KEY, KEY, c_false, c_true)
-#define forward_csset(CX, KEY) _c_aatree_types(CX, KEY, KEY, c_false, c_true)
+#define forward_cmap(CX, KEY, VAL) _c_chash_types(CX, KEY, VAL, MAP_SIZE_T, c_true, c_false, c_false, c_false, c_false, c_false, c_false)
+#define forward_csmap(CX, KEY, VAL) _c_aatree_types(CX, KEY, VAL, MAP_SIZE_T, c_true, c_false)
+#define forward_cbtmap(CX, KEY, VAL) _c_btree_types(CX, KEY, VAL, c_true, c_false)
+#define forward_cset(CX, KEY) _c_chash_types(CX, KEY, KEY, MAP_SIZE_T, c_false, c_true, c_false, c_false, c_false, c_false, c_false)
+#define forward_csset(CX, KEY) _c_aatree_types(CX, KEY, KEY, MAP_SIZE_T, c_false, c_true)
+#define forward_cbtset(CX, KEY) _c_btree_types(CX, KEY, KEY, c_false, c_true)
 #define forward_csptr(CX, VAL) _c_csptr_types(CX, VAL)
 #define forward_cpque(CX, VAL) _c_cpque_types(CX, VAL)
 #define forward_cstack(CX, VAL) _c_cstack_types(CX, VAL)
@@ -73,10 +75,10 @@
         SELF##_node_t *last; \
     } SELF
 
-#define _c_chash_types(SELF, KEY, VAL, MAP_ONLY, SET_ONLY) \
+#define _c_chash_types(SELF, KEY, VAL, SIZE, MAP_ONLY, SET_ONLY, INCR_ONLY, HASH_ONLY, STAT_ONLY, INL_ONLY, SOA_ONLY) \
     typedef KEY SELF##_key_t; \
     typedef VAL SELF##_mapped_t; \
-    typedef MAP_SIZE_T SELF##_size_t; \
+    typedef SIZE SELF##_size_t; \
 \
     typedef SET_ONLY( SELF##_key_t ) \
             MAP_ONLY( struct SELF##_value_t ) \
@@ -90,6 +92,7 @@
     typedef struct { \
         SELF##_value_t *ref; \
         uint8_t* _hx; \
+        INCR_ONLY( uint8_t *_hxend, *_ohx; SELF##_value_t *_oref; ) \
     } SELF##_iter_t; \
 \
     typedef struct { \
@@ -97,12 +100,18 @@
         uint8_t* _hashx; \
         SELF##_size_t size, bucket_count; \
         float max_load_factor; \
+        INCR_ONLY( SELF##_value_t* _otable; uint8_t* _ohashx; \
+                   SELF##_size_t _osize, _obucket_count, _opos; ) \
+        HASH_ONLY( SELF##_size_t* _hashv; INCR_ONLY( SELF##_size_t* _ohashv; ) ) \
+        SOA_ONLY( SELF##_mapped_t* _vals; ) \
+        STAT_ONLY( size_t _rehashes, _probes, _equals; ) \
+        INL_ONLY( SELF##_value_t _inl[SELF##_INLINE]; ) \
     } SELF
 
-#define _c_aatree_types(SELF, KEY, VAL, MAP_ONLY, SET_ONLY) \
+#define _c_aatree_types(SELF, KEY, VAL, SIZE, MAP_ONLY, SET_ONLY) \
     typedef KEY SELF##_key_t; \
     typedef VAL SELF##_mapped_t; \
-    typedef MAP_SIZE_T SELF##_size_t; \
+    typedef SIZE SELF##_size_t; \
     typedef struct SELF##_node_t SELF##_node_t; \
 \
     typedef SET_ONLY( SELF##_key_t ) \
@@ -118,13 +127,39 @@
         SELF##_value_t *ref; \
         SELF##_node_t *_d; \
         int _top; \
-        SELF##_size_t _tn, _st[36]; \
+        SELF##_size_t _tn, _st[sizeof(SIZE)*9]; \
     } SELF##_iter_t; \
 \
     typedef struct { \
         SELF##_node_t *nodes; \
     } SELF
 
+#define _c_btree_types(SELF, KEY, VAL, MAP_ONLY, SET_ONLY) \
+    typedef KEY SELF##_key_t; \
+    typedef VAL SELF##_mapped_t; \
+    typedef struct SELF##_leaf_t SELF##_leaf_t; \
+\
+    typedef SET_ONLY( SELF##_key_t ) \
+            MAP_ONLY( struct SELF##_value_t ) \
+    SELF##_value_t; \
+\
+    typedef struct { \
+        SELF##_value_t *ref; \
+        bool inserted; \
+    } SELF##_result_t; \
+\
+    typedef struct { \
+        SELF##_value_t *ref, *_end; \
+        SELF##_leaf_t *_leaf; \
+    } SELF##_iter_t; \
+\
+    typedef struct { \
+        void *root; \
+        SELF##_leaf_t *_first; \
+        size_t size; \
+        int _height; \
+    } SELF
+
 #define _c_csptr_types(SELF, VAL) \
     typedef VAL SELF##_value_t; \
 \
@@ -183,6 +183,20 @@
 #undef i_key_csptr
 #undef i_val_csptr
 #undef i_cnt
+#undef i_simd
+#undef i_incremental
+#undef i_storehash
+#undef i_stats
+#undef i_hugepages
+#undef i_inline
+#undef i_soa
+#undef i_multi
+#undef i_clock
+#undef i_cost
+#undef i_robinhood
+#undef i_persist
+#undef i_size
+#undef i_ordstat
 #undef Self
 
 #undef i_template